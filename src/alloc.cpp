@@ -0,0 +1,47 @@
+/*
+ * Copyright 2017-2018 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include <sys/mman.h>
+
+#include "alloc.hpp"
+
+namespace pg {
+
+void *
+alloc_aligned(size_t size)
+{
+    if (size == 0) size = 1;
+    const bool huge = size >= HUGE_PAGE_THRESHOLD;
+
+    void *ptr;
+    if (posix_memalign(&ptr, huge ? HUGE_PAGE_THRESHOLD : 64, size) != 0) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+    // (only a hint; fails harmlessly if transparent huge pages are disabled)
+    if (huge) madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+    return ptr;
+}
+
+void
+free_aligned(void *ptr)
+{
+    free(ptr);
+}
+
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2017-2018 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ALLOC_HPP
+#define ALLOC_HPP
+
+#include <cstddef>
+
+namespace pg {
+
+/**
+ * Arrays of at least this many bytes are aligned to 2 MB and use transparent huge pages (if available).
+ */
+static const size_t HUGE_PAGE_THRESHOLD = 2*1024*1024;
+
+/**
+ * Allocate <size> bytes aligned to a cache line (64 bytes), or for large sizes aligned to a huge page
+ * and advised to be backed by huge pages. Throws std::bad_alloc on failure. Free with free_aligned.
+ */
+void *alloc_aligned(size_t size);
+
+/**
+ * Free memory that was allocated with alloc_aligned.
+ */
+void free_aligned(void *ptr);
+
+/**
+ * Allocate an (uninitialized) array of <count> items with alloc_aligned, for the large arrays of
+ * games and solvers (less TLB misses on random access). Free with free_array.
+ */
+template <typename T>
+inline T*
+alloc_array(size_t count)
+{
+    return (T*)alloc_aligned(sizeof(T) * count);
+}
+
+template <typename T>
+inline void
+free_array(T *arr)
+{
+    free_aligned((void*)arr);
+}
+
+}
+
+#endif
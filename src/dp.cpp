@@ -42,7 +42,7 @@ DPSolver::getRegionStatus(int i, int p)
         } else {
             // region lost by escape owner
             // it is therefore closed if there are no edges to lower regions
-            for (auto to : out[j]) {
+            for (auto to : out(j)) {
                 if (disabled[to]) continue;
                 int r = region[to];
                 if (region_[to] > r) r = region_[to]; // update from region_
@@ -55,7 +55,7 @@ DPSolver::getRegionStatus(int i, int p)
     for (auto j : regions[p]) {
         if (owner[j] != pl) {
             // losing node, find lowest higher ...
-            for (auto to : out[j]) {
+            for (auto to : out(j)) {
                 /** HOT SPOT of the iterator and minor hot spot of obtaining the region **/
                 if (disabled[to]) continue;
                 int r = region[to];
@@ -61,7 +61,7 @@ struct zsolver {
         degs[v] = 1;
       else {
         degs[v] = 0;
-        for(auto w: g->out[v]) if(vtype[w] == cat_no || vtype[w] == cat_yes) degs[v]++;
+        for(auto w: g->out(v)) if(vtype[w] == cat_no || vtype[w] == cat_yes) degs[v]++;
         }
       
     // invariant: degs[v] is the number of edges from v which we need to prove that
@@ -69,7 +69,7 @@ struct zsolver {
     // a vertex is 'proven' if it has been already considered as v below
     for(int i=0; i < int(aqueue.size()); i++) {
       int v = aqueue[i];
-      for(auto w: g->in[v]) {
+      for(auto w: g->in(v)) {
         degs[w]--;
         if(degs[w] == 0) {
         
@@ -187,7 +187,7 @@ void zsolver::run(const std::vector<int>& vs, int cat_base, std::array<int, 2> p
       // strategy not specified for maxprio yet
       for(auto v: vs) if(g->priority[v] == maxprio) {
         if(g->owner[v] == us) {
-          for(auto e: g->out[v]) if(vtype[e] == cat_hiprio) strategy[v] = e;
+          for(auto e: g->out(v)) if(vtype[e] == cat_hiprio) strategy[v] = e;
           }
         else 
           strategy[v] = -1;
@@ -229,9 +229,9 @@ DEB(    for(int i=0; i<myindent; i++) logger << " ";
     
 DEB(
     for(auto v: vs) if(strategy[v] == -1) {
-      for(auto e: g->out[v]) if(g->owner[v] == g->owner[e] && strategy[e] >= 0)
+      for(auto e: g->out(v)) if(g->owner[v] == g->owner[e] && strategy[e] >= 0)
         logger << "Escape A\n";
-      for(auto e: g->out[v]) if(g->owner[v] != g->owner[e] && strategy[e] == -1)
+      for(auto e: g->out(v)) if(g->owner[v] != g->owner[e] && strategy[e] == -1)
         logger << "Escape B\n";
       } )
     }
@@ -254,9 +254,9 @@ void ExperimentalSolver::run()
 /*
     for (int i=0; i<n_nodes; i++) {
       fmt::printf(logger, "Vertex %d: owner %d, priority %d\n", i, (int) owner[i], (int) priority[i]);
-      for(auto e: out[i])
+      for(auto e: out(i))
         fmt::printf(logger, "Out-edge to %d\n", (int) e);
-      for(auto e: in[i])
+      for(auto e: in(i))
         fmt::printf(logger, "In-edge from %d\n", (int) e);
       } */
     
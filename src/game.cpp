@@ -15,46 +15,69 @@
  */
 
 #include <cassert>
+#include <cstdint>
 #include <cstring> // memset
 #include <iostream>
 #include <algorithm>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "game.hpp"
+#include "parallel.hpp"
 
 using namespace std;
 
 namespace pg {
 
-Game::Game() :
-    n_nodes(0), n_edges(0),
-    priority(new int[n_nodes]), owner(n_nodes), label(new std::string[n_nodes]),
-    out(new std::vector<int>[n_nodes]), in(new std::vector<int>[n_nodes]),
-    solved(n_nodes), winner(n_nodes), strategy(new int[n_nodes])
+Game::Game() : Game(0)
 {
 }
 
 Game::Game(int count) :
     n_nodes(count), n_edges(0),
-    priority(new int[n_nodes]), owner(n_nodes), label(new std::string[n_nodes]),
-    out(new std::vector<int>[n_nodes]), in(new std::vector<int>[n_nodes]),
-    solved(n_nodes), winner(n_nodes), strategy(new int[n_nodes])
+    priority(alloc_array<int>(n_nodes)), owner(n_nodes), label(n_nodes),
+    outa(alloc_array<edge_offset>(n_nodes+1)), ina(alloc_array<edge_offset>(n_nodes+1)),
+    outs(alloc_array<int>(n_nodes)), ins(alloc_array<int>(n_nodes)),
+    vout(NULL), vin(NULL),
+    solved(n_nodes), winner(n_nodes), strategy(new int[n_nodes]),
+    mapped(NULL), mapped_size(0), refs(new int(1)), strategy_refs(new int(1))
 {
-    assert(count > 0);
+    assert(count >= 0);
     memset(strategy, -1, sizeof(int[n_nodes]));
+    // start with empty (-1 terminated) edge lists
+    for (int i=0; i<=n_nodes; i++) outa[i] = ina[i] = i;
+    memset(outs, -1, sizeof(int[n_nodes]));
+    memset(ins, -1, sizeof(int[n_nodes]));
 }
 
-Game::Game(const Game& other) : Game(other.n_nodes)
+Game::Game(const Game& other) :
+    n_nodes(other.n_nodes), n_edges(other.n_edges),
+    priority(other.priority), owner(other.owner), label(other.label),
+    outa(other.outa), ina(other.ina), outs(other.outs), ins(other.ins),
+    vout(NULL), vin(NULL),
+    solved(other.solved), winner(other.winner), strategy(other.strategy),
+    mapped(other.mapped), mapped_size(other.mapped_size), refs(other.refs), strategy_refs(other.strategy_refs)
 {
-    n_edges = other.n_edges;
-    memcpy(priority, other.priority, sizeof(int[n_nodes]));
-    owner = other.owner;
-    for (int i=0; i<n_nodes; i++) label[i] = other.label[i];
-    for (int i=0; i<n_nodes; i++) out[i] = other.out[i];
-    for (int i=0; i<n_nodes; i++) in[i] = other.in[i];
+    __sync_fetch_and_add(strategy_refs, 1);
 
-    solved = other.solved;
-    winner = other.winner;
-    memcpy(strategy, other.strategy, sizeof(int[n_nodes]));
+    if (other.isBuilt()) {
+        // share the priorities and the edge arrays
+        __sync_fetch_and_add(refs, 1);
+    } else {
+        // the builder vectors are not shared
+        priority = alloc_array<int>(n_nodes);
+        memcpy(priority, other.priority, sizeof(int[n_nodes]));
+        mapped = NULL;
+        mapped_size = 0;
+        refs = new int(1);
+        vout = new std::vector<int>[n_nodes];
+        vin = new std::vector<int>[n_nodes];
+        for (int i=0; i<n_nodes; i++) vout[i] = other.vout[i];
+        for (int i=0; i<n_nodes; i++) vin[i] = other.vin[i];
+    }
 }
 
 static void
@@ -85,7 +108,57 @@ read_uint64(std::streambuf *rd, uint64_t *res)
     return true;
 }
 
-Game::Game(istream &inp)
+/**
+ * Build the -1 terminated CSR arrays for <n_nodes> nodes from a flat list of (from,to) <edges>.
+ * Uses a counting sort, so successors and predecessors keep the order of <edges>,
+ * and the arrays have the exact size (no per-node vectors, no slack).
+ */
+static void
+edges_to_csr(int n_nodes, const std::vector<std::pair<int, int>> &edges, edge_offset *&outa, edge_offset *&ina, int *&outs, int *&ins)
+{
+    // check the edges before allocating, so nothing leaks
+    for (auto &e : edges) {
+        if (e.second < 0 or e.second >= n_nodes) throw "invalid successor";
+    }
+
+    outa = alloc_array<edge_offset>(n_nodes+1);
+    ina = alloc_array<edge_offset>(n_nodes+1);
+    memset(outa, 0, sizeof(edge_offset[n_nodes+1]));
+    memset(ina, 0, sizeof(edge_offset[n_nodes+1]));
+
+    // count degrees, then compute the start of each list (plus a terminator per node)
+    for (auto &e : edges) {
+        outa[e.first]++;
+        ina[e.second]++;
+    }
+    edge_offset outi = 0, ini = 0;
+    for (int i=0; i<n_nodes; i++) {
+        const edge_offset od = outa[i], id = ina[i];
+        outa[i] = outi;
+        ina[i] = ini;
+        outi += od + 1;
+        ini += id + 1;
+    }
+    outs = alloc_array<int>(outi);
+    ins = alloc_array<int>(ini);
+
+    // fill, using <outa>/<ina> as cursors; afterwards they point to the terminators
+    for (auto &e : edges) {
+        outs[outa[e.first]++] = e.second;
+        ins[ina[e.second]++] = e.first;
+    }
+    for (int i=0; i<n_nodes; i++) {
+        outs[outa[i]] = -1;
+        ins[ina[i]] = -1;
+    }
+    for (int i=n_nodes; i>0; i--) {
+        outa[i] = outa[i-1] + 1;
+        ina[i] = ina[i-1] + 1;
+    }
+    outa[0] = ina[0] = 0;
+}
+
+Game::Game(istream &inp) : mapped(NULL), mapped_size(0), refs(new int(1)), strategy_refs(new int(1))
 {
     std::streambuf *rd = inp.rdbuf();
 
@@ -115,11 +188,12 @@ Game::Game(istream &inp)
     n_nodes = n+1; // plus 1, in case this parity game encodes "max id" instead of "n_nodes"
     n_edges = 0;
 
-    priority = new int[n_nodes];
+    priority = alloc_array<int>(n_nodes);
     owner.resize(n_nodes);
-    label = new std::string[n_nodes];
-    out = new std::vector<int>[n_nodes];
-    in = new std::vector<int>[n_nodes];
+    label = label_pool(n_nodes);
+    outa = ina = NULL;
+    outs = ins = NULL;
+    vout = vin = NULL;
 
     solved.resize(n_nodes);
     winner.resize(n_nodes);
@@ -133,6 +207,7 @@ Game::Game(istream &inp)
      */
 
     int node_count = 0; // number of read nodes
+    std::vector<std::pair<int, int>> edges; // all (from,to) edges, in order
 
     while (node_count < n_nodes) {
         uint64_t id;
@@ -173,9 +248,7 @@ Game::Game(istream &inp)
                 std::cout << "id " << id << " with successor " << n << std::endl;
                 throw "invalid successor";}
 
-            out[id].push_back(n);
-            in[n].push_back(id);
-            n_edges++;
+            edges.push_back(std::make_pair((int)id, (int)n));
 
             char ch;
             skip_whitespace(rd);
@@ -183,30 +256,181 @@ Game::Game(istream &inp)
             if (ch == ',') continue; // next successor
             if (ch == ';') break; // end of line
             if (ch == '\"') {
+                std::string str;
                 while (true) {
                     inp >> ch;
                     if (ch == '\"') break;
-                    label[id] += ch;
+                    str += ch;
                 }
+                label.set(id, str);
                 // now read ;
                 skip_whitespace(rd);
                 if (!(inp >> ch) or ch != ';') throw "missing ; to end line";
             }
-            else label[id] = "";
             break;
         }
     }
 
     if (solved.any()) throw "missing nodes";
+
+    n_edges = edges.size();
+    edges_to_csr(n_nodes, edges, outa, ina, outs, ins);
+}
+
+GameBuilder::GameBuilder(int count) : game(count)
+{
+}
+
+void
+GameBuilder::initNode(int node, int priority, int owner, std::string label)
+{
+    game.initNode(node, priority, owner, label);
+}
+
+void
+GameBuilder::addEdges(int from, const int *to, size_t count)
+{
+    for (size_t i=0; i<count; i++) edges.push_back(std::make_pair(from, to[i]));
+}
+
+void
+GameBuilder::addEdges(const std::vector<std::pair<int, int>> &edges)
+{
+    this->edges.insert(this->edges.end(), edges.begin(), edges.end());
+}
+
+void
+GameBuilder::build(Game &res)
+{
+    const int n_nodes = game.n_nodes;
+
+    // group the edges by source (counting sort)...
+    std::vector<size_t> start(n_nodes+1, 0);
+    for (auto &e : edges) {
+        assert(e.first >= 0 and e.first < n_nodes);
+        assert(e.second >= 0 and e.second < n_nodes);
+        start[e.first+1]++;
+    }
+    for (int i=0; i<n_nodes; i++) start[i+1] += start[i];
+
+    std::vector<std::pair<int, int>> grouped(edges.size());
+    {
+        std::vector<size_t> pos(start.begin(), start.end()-1);
+        for (auto &e : edges) grouped[pos[e.first]++] = e;
+    }
+    std::vector<std::pair<int, int>>().swap(edges);
+
+    // ...then sort each group and remove duplicates, compacting in place
+    size_t count = 0;
+    for (int i=0; i<n_nodes; i++) {
+        std::sort(grouped.begin() + start[i], grouped.begin() + start[i+1]);
+        const size_t first = count;
+        for (size_t k=start[i]; k<start[i+1]; k++) {
+            if (count != first and grouped[count-1] == grouped[k]) continue;
+            grouped[count++] = grouped[k];
+        }
+    }
+    grouped.resize(count);
+
+    edge_offset *outa, *ina;
+    int *outs, *ins;
+    edges_to_csr(n_nodes, grouped, outa, ina, outs, ins);
+    free_array(game.outa);
+    free_array(game.ina);
+    free_array(game.outs);
+    free_array(game.ins);
+    game.n_edges = count;
+    game.outa = outa;
+    game.ina = ina;
+    game.outs = outs;
+    game.ins = ins;
+
+    res.swap(game);
+    Game().swap(game);
 }
 
 Game::~Game()
 {
-    delete[] priority;
-    delete[] out;
-    delete[] in;
-    delete[] label;
+    release_shared();
+    delete[] vout;
+    delete[] vin;
+    release_strategy();
+}
+
+void
+Game::release_shared()
+{
+    if (__sync_sub_and_fetch(refs, 1) != 0) return;
+    release(priority);
+    release(outa);
+    release(ina);
+    release(outs);
+    release(ins);
+    if (mapped != NULL) munmap(mapped, mapped_size);
+    delete refs;
+}
+
+void
+Game::release_strategy()
+{
+    if (__sync_sub_and_fetch(strategy_refs, 1) != 0) return;
     delete[] strategy;
+    delete strategy_refs;
+}
+
+/**
+ * Copy the <count> ints at <arr> to a new array (or NULL if <arr> is NULL).
+ */
+template <typename T>
+static T*
+copy_array(const T *arr, size_t count)
+{
+    if (arr == NULL) return NULL;
+    T *res = alloc_array<T>(count);
+    memcpy(res, arr, sizeof(T[count]));
+    return res;
+}
+
+void
+Game::unshare()
+{
+    if (*refs == 1) return;
+
+    // (shared games are built, see the copy constructor)
+    int *new_priority = copy_array(priority, n_nodes);
+    edge_offset *new_outa = copy_array(outa, n_nodes+1);
+    edge_offset *new_ina = copy_array(ina, n_nodes+1);
+    int *new_outs = copy_array(outs, outa[n_nodes]);
+    int *new_ins = copy_array(ins, ina[n_nodes]);
+
+    replace_arrays(new_priority, new_outa, new_ina, new_outs, new_ins);
+}
+
+void
+Game::unshare_strategy()
+{
+    if (*strategy_refs == 1) return;
+
+    int *new_strategy = new int[n_nodes];
+    memcpy(new_strategy, strategy, sizeof(int[n_nodes]));
+    release_strategy();
+    strategy = new_strategy;
+    strategy_refs = new int(1);
+}
+
+void
+Game::replace_arrays(int *priority, edge_offset *outa, edge_offset *ina, int *outs, int *ins)
+{
+    release_shared();
+
+    this->priority = priority;
+    this->outa = outa;
+    this->ina = ina;
+    this->outs = outs;
+    this->ins = ins;
+    mapped = NULL;
+    mapped_size = 0;
+    refs = new int(1);
 }
 
 void
@@ -222,9 +446,10 @@ Game::initNode(int node, int priority, int owner, std::string label)
     assert(node >= 0 and node < n_nodes);
     assert(owner == 0 or owner == 1);
 
+    unshare();
     this->priority[node] = priority;
     this->owner[node] = owner;
-    this->label[node] = label;
+    this->label.set(node, label);
 }
 
 bool
@@ -233,9 +458,11 @@ Game::addEdge(int from, int to)
     assert(from >= 0 and from < n_nodes);
     assert(to >= 0 and to < n_nodes);
 
-    if (std::find(out[from].begin(), out[from].end(), to) == out[from].end()) {
-        out[from].push_back(to);
-        in[to].push_back(from);
+    unbuild();
+
+    if (std::find(vout[from].begin(), vout[from].end(), to) == vout[from].end()) {
+        vout[from].push_back(to);
+        vin[to].push_back(from);
         n_edges++;
         return true;
     } else {
@@ -243,32 +470,437 @@ Game::addEdge(int from, int to)
     }
 }
 
+/**
+ * Remove <value> from the -1 terminated list at <list>, moving the remaining items forward.
+ * Returns true if the value was found.
+ */
+static bool
+remove_terminated(int *list, int value)
+{
+    int *ptr = list;
+    while (*ptr != -1 and *ptr != value) ptr++;
+    if (*ptr == -1) return false;
+    for (; *ptr != -1; ptr++) ptr[0] = ptr[1];
+    return true;
+}
+
 bool
 Game::removeEdge(int from, int to)
 {
     assert(from >= 0 and from < n_nodes);
     assert(to >= 0 and to < n_nodes);
 
-    auto &o = out[from];
-    auto &i = in[to];
+    if (isBuilt()) {
+        unshare();
+        if (!remove_terminated(outs + outa[from], to)) return false;
+        remove_terminated(ins + ina[to], from);
+        n_edges--;
+        return true;
+    }
+
+    auto &o = vout[from];
+    auto &i = vin[to];
 
     auto pre = o.size();
     o.erase(std::remove(o.begin(), o.end(), to), o.end());
     if (o.size() == pre) return false;
     i.erase(std::remove(i.begin(), i.end(), from), i.end());
+    n_edges--;
     return true;
 }
 
+void
+Game::build()
+{
+    if (isBuilt()) return;
+
+    // count edges (plus a terminator per node)
+    size_t outlen = 0, inlen = 0;
+    for (int i=0; i<n_nodes; i++) {
+        outlen += vout[i].size() + 1;
+        inlen += vin[i].size() + 1;
+    }
+
+    outa = alloc_array<edge_offset>(n_nodes+1);
+    ina = alloc_array<edge_offset>(n_nodes+1);
+    outs = alloc_array<int>(outlen);
+    ins = alloc_array<int>(inlen);
+
+    edge_offset outi = 0;
+    edge_offset ini = 0;
+
+    for (int i=0; i<n_nodes; i++) {
+        outa[i] = outi;
+        ina[i] = ini;
+        for (int to : vout[i]) outs[outi++] = to;
+        for (int fr : vin[i]) ins[ini++] = fr;
+        outs[outi++] = -1;
+        ins[ini++] = -1;
+    }
+    outa[n_nodes] = outi;
+    ina[n_nodes] = ini;
+
+    delete[] vout;
+    delete[] vin;
+    vout = vin = NULL;
+}
+
+void
+Game::unbuild()
+{
+    if (!isBuilt()) return;
+
+    unshare();
+
+    vout = new std::vector<int>[n_nodes];
+    vin = new std::vector<int>[n_nodes];
+
+    for (int i=0; i<n_nodes; i++) {
+        for (const int *_out = outs + outa[i]; *_out != -1; _out++) vout[i].push_back(*_out);
+        for (const int *_in = ins + ina[i]; *_in != -1; _in++) vin[i].push_back(*_in);
+    }
+
+    release(outa);
+    release(ina);
+    release(outs);
+    release(ins);
+    outa = ina = NULL;
+    outs = ins = NULL;
+}
+
 void
 Game::parse_pgsolver(std::istream &in)
 {
+    // seekable streams (files) are read at once and parsed with the buffer parser
+    std::streambuf *buf = in.rdbuf();
+    const std::streamoff start = std::streamoff(buf->pubseekoff(0, std::ios_base::cur, std::ios_base::in));
+    const std::streamoff last = start == -1 ? -1 : std::streamoff(buf->pubseekoff(0, std::ios_base::end, std::ios_base::in));
+    if (start != -1 and last != -1 and buf->pubseekpos(start, std::ios_base::in) == start) {
+        std::vector<char> data(last - start);
+        if (buf->sgetn(data.data(), data.size()) == (std::streamsize)data.size()) {
+            parse_pgsolver(data.data(), data.size(), 1);
+            return;
+        }
+        buf->pubseekpos(start, std::ios_base::in);
+    }
+
+    // otherwise the streambuf parser
     Game g(in);
     swap(g);
 }
 
+/**
+ * Header of the binary game format (.pgb).
+ * The header is followed by these arrays, each padded to a multiple of 8 bytes:
+ * priority (int32[n_nodes]), owner (uint64[(n_nodes+63)/64]),
+ * outa (int64[n_nodes+1]), ina (int64[n_nodes+1]), outs (int32[outlen]), ins (int32[inlen]).
+ * All values are in native byte order; <endian> detects files from other platforms.
+ */
+struct pgb_header
+{
+    char magic[8];      // "OINKPGB"
+    uint32_t version;   // PGB_VERSION
+    uint32_t endian;    // PGB_ENDIAN
+    uint64_t n_nodes;   // number of nodes
+    uint64_t n_edges;   // number of edges
+    uint64_t outlen;    // length of outs (including terminators)
+    uint64_t inlen;     // length of ins (including terminators)
+};
+
+static_assert(sizeof(bitset::block_type) == 8, "owner blocks must be 64-bit");
+
+static const char PGB_MAGIC[8] = "OINKPGB";
+static const uint32_t PGB_VERSION = 2;
+static const uint32_t PGB_ENDIAN = 0x01020304;
+
+static inline size_t
+pgb_pad(size_t size)
+{
+    return (size + 7) & ~(size_t)7;
+}
+
+/**
+ * Check that the -1 terminated lists of the <n> nodes in <index>/<edges> (of length <len>) are valid:
+ * the offsets start at 0, increase, end at <len>, and each list has only nodes before its terminator.
+ */
+static bool
+pgb_valid_csr(const edge_offset *index, const int *edges, size_t n, uint64_t len)
+{
+    if (index[0] != 0 or (uint64_t)index[n] != len) return false;
+    for (size_t i=0; i<n; i++) {
+        if (index[i+1] <= index[i]) return false;
+        const edge_offset last = index[i+1]-1;
+        for (edge_offset k=index[i]; k<last; k++) {
+            if (edges[k] < 0 or (size_t)edges[k] >= n) return false;
+        }
+        if (edges[last] != -1) return false;
+    }
+    return true;
+}
+
+/**
+ * Check that the in-lists are the transpose of the out-lists (of valid CSR arrays): every node has
+ * as many predecessors as it is the successor of other nodes, and the sums of their indices match.
+ */
+static bool
+pgb_valid_transpose(const edge_offset *outa, const int *outs, const edge_offset *ina, const int *ins, size_t n)
+{
+    std::vector<int64_t> count(n, 0);
+    std::vector<uint64_t> sum(n, 0);
+    for (size_t i=0; i<n; i++) {
+        for (edge_offset k=outa[i]; outs[k] != -1; k++) {
+            count[outs[k]]++;
+            sum[outs[k]] += i;
+        }
+    }
+    for (size_t i=0; i<n; i++) {
+        if (count[i] != ina[i+1]-ina[i]-1) return false;
+        for (edge_offset k=ina[i]; ins[k] != -1; k++) sum[i] -= ins[k];
+        if (sum[i] != 0) return false;
+    }
+    return true;
+}
+
+void
+Game::load_binary(const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) throw "unable to open file";
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); throw "unable to open file"; }
+    const size_t size = st.st_size;
+    if (size < sizeof(pgb_header)) { close(fd); throw "invalid binary game"; }
+
+    // private mapping, so in-place changes to the game never reach the file
+    void *ptr = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) throw "unable to map file";
+
+    char *base = (char*)ptr;
+    const pgb_header *hdr = (const pgb_header*)base;
+
+    const char *err = NULL;
+    if (memcmp(hdr->magic, PGB_MAGIC, 8) != 0) err = "invalid binary game";
+    else if (hdr->endian != PGB_ENDIAN) err = "binary game has wrong byte order";
+    else if (hdr->version != PGB_VERSION) err = "unsupported binary game version";
+    else if (hdr->n_nodes > INT32_MAX) err = "binary game too large";
+    else if (hdr->outlen > (uint64_t)size / sizeof(int) or hdr->inlen > (uint64_t)size / sizeof(int)) err = "truncated binary game";
+    if (err != NULL) { munmap(ptr, size); throw err; }
+
+    const size_t n = hdr->n_nodes;
+    const size_t off_priority = pgb_pad(sizeof(pgb_header));
+    const size_t off_owner = off_priority + pgb_pad(sizeof(int[n]));
+    const size_t off_outa = off_owner + sizeof(uint64_t[(n+63)/64]);
+    const size_t off_ina = off_outa + sizeof(edge_offset[n+1]);
+    const size_t off_outs = off_ina + sizeof(edge_offset[n+1]);
+    const size_t off_ins = off_outs + pgb_pad(sizeof(int[hdr->outlen]));
+    const size_t off_end = off_ins + pgb_pad(sizeof(int[hdr->inlen]));
+
+    if (size < off_end) { munmap(ptr, size); throw "truncated binary game"; }
+
+    // the CSR arrays must be consistent with the header, and every edge must be to a node
+    edge_offset *_outa = (edge_offset*)(base + off_outa);
+    edge_offset *_ina = (edge_offset*)(base + off_ina);
+    const int *_outs = (const int*)(base + off_outs);
+    const int *_ins = (const int*)(base + off_ins);
+    if (!pgb_valid_csr(_outa, _outs, n, hdr->outlen) or !pgb_valid_csr(_ina, _ins, n, hdr->inlen) or
+            hdr->n_edges != hdr->outlen - n or !pgb_valid_transpose(_outa, _outs, _ina, _ins, n)) {
+        munmap(ptr, size);
+        throw "invalid binary game";
+    }
+
+    // priorities are not negative, and the solvers size arrays by the highest priority + 1
+    const int *_priority = (const int*)(base + off_priority);
+    int max_prio = 0;
+    for (size_t i=0; i<n; i++) {
+        if (_priority[i] < 0) { munmap(ptr, size); throw "invalid priority"; }
+        max_prio = std::max(max_prio, _priority[i]);
+    }
+    if (max_prio == INT32_MAX) { munmap(ptr, size); throw "invalid priority"; }
+
+    // swap into a fresh game, releasing the arrays it allocated
+    Game g;
+    free_array(g.priority);
+    free_array(g.outa);
+    free_array(g.ina);
+    free_array(g.outs);
+    free_array(g.ins);
+    delete[] g.strategy;
+
+    g.mapped = base;
+    g.mapped_size = size;
+    g.n_nodes = n;
+    g.n_edges = hdr->n_edges;
+    g.priority = (int*)_priority;
+    g.owner.resize(n);
+    const bitset::block_type *_owner = (const bitset::block_type*)(base + off_owner);
+    boost::from_block_range(_owner, _owner + (n+63)/64, g.owner);
+    g.owner.resize(n); // drop padding bits
+    g.label = label_pool(n);
+    g.outa = _outa;
+    g.ina = _ina;
+    g.outs = (int*)(base + off_outs);
+    g.ins = (int*)(base + off_ins);
+
+    g.solved.resize(n);
+    g.winner.resize(n);
+    g.strategy = new int[n];
+    memset(g.strategy, -1, sizeof(int[n]));
+
+    swap(g);
+}
+
+void
+Game::write_binary(std::ostream &os)
+{
+    build();
+
+    pgb_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, PGB_MAGIC, 8);
+    hdr.version = PGB_VERSION;
+    hdr.endian = PGB_ENDIAN;
+    hdr.n_nodes = n_nodes;
+    hdr.n_edges = n_edges;
+    hdr.outlen = outa[n_nodes];
+    hdr.inlen = ina[n_nodes];
+
+    static const char zeros[8] = { 0 };
+    auto write = [&] (const void *data, size_t len) {
+        os.write((const char*)data, len);
+        os.write(zeros, pgb_pad(len) - len);
+    };
+
+    write(&hdr, sizeof(hdr));
+    write(priority, sizeof(int[n_nodes]));
+    {
+        std::vector<bitset::block_type> blocks(owner.num_blocks());
+        boost::to_block_range(owner, blocks.begin());
+        write(blocks.data(), sizeof(bitset::block_type[blocks.size()]));
+    }
+    write(outa, sizeof(edge_offset[n_nodes+1]));
+    write(ina, sizeof(edge_offset[n_nodes+1]));
+    write(outs, sizeof(int[outa[n_nodes]]));
+    write(ins, sizeof(int[ina[n_nodes]]));
+
+    if (!os) throw "unable to write binary game";
+}
+
+/**
+ * Header of the binary solution format.
+ * The header is followed by these arrays, each padded to a multiple of 8 bytes:
+ * solved (uint64[(n_nodes+63)/64]), winner (uint64[(n_nodes+63)/64]), strategy (int32[n_nodes]).
+ */
+struct psb_header
+{
+    char magic[8];      // "OINKSOL"
+    uint32_t version;   // PSB_VERSION
+    uint32_t endian;    // PGB_ENDIAN
+    uint64_t n_nodes;   // number of nodes of the game
+    uint64_t n_solved;  // number of solved nodes
+};
+
+static const char PSB_MAGIC[8] = "OINKSOL";
+static const uint32_t PSB_VERSION = 1;
+
+void
+Game::load_solution_binary(const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) throw "unable to open file";
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); throw "unable to open file"; }
+    const size_t size = st.st_size;
+    if (size < sizeof(psb_header)) { close(fd); throw "invalid binary solution"; }
+
+    void *ptr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) throw "unable to map file";
+    madvise(ptr, size, MADV_SEQUENTIAL);
+
+    const char *base = (const char*)ptr;
+    const psb_header *hdr = (const psb_header*)base;
+    const size_t n = n_nodes;
+    const size_t n_blocks = (n+63)/64;
+    const size_t off_solved = pgb_pad(sizeof(psb_header));
+    const size_t off_winner = off_solved + sizeof(uint64_t[n_blocks]);
+    const size_t off_strategy = off_winner + sizeof(uint64_t[n_blocks]);
+    const size_t off_end = off_strategy + pgb_pad(sizeof(int[n]));
+
+    const char *err = NULL;
+    if (memcmp(hdr->magic, PSB_MAGIC, 8) != 0) err = "invalid binary solution";
+    else if (hdr->endian != PGB_ENDIAN) err = "binary solution has wrong byte order";
+    else if (hdr->version != PSB_VERSION) err = "unsupported binary solution version";
+    else if (hdr->n_nodes != n) err = "binary solution does not match the game";
+    else if (size < off_end) err = "truncated binary solution";
+    if (err != NULL) { munmap(ptr, size); throw err; }
+
+    bitset sol_solved(n), sol_winner(n);
+    const bitset::block_type *_solved = (const bitset::block_type*)(base + off_solved);
+    const bitset::block_type *_winner = (const bitset::block_type*)(base + off_winner);
+    boost::from_block_range(_solved, _solved + n_blocks, sol_solved);
+    boost::from_block_range(_winner, _winner + n_blocks, sol_winner);
+    sol_solved.resize(n); // drop padding bits
+    sol_winner.resize(n);
+    const int *_strategy = (const int*)(base + off_strategy);
+
+    // same checks as parse_solution; only strategies of the winner count
+    if (sol_solved.intersects(solved)) err = "node already solved";
+    for (size_t i=0; i<n and err == NULL; i++) {
+        if (!sol_solved[i] or sol_winner[i] != owner[i]) continue;
+        const int str = _strategy[i];
+        if (str == -1) err = "missing strategy for winning node";
+        else if (std::find(out(i).begin(), out(i).end(), str) == out(i).end()) err = "strategy not successor of node";
+    }
+    if (err != NULL) { munmap(ptr, size); throw err; }
+
+    unshare_strategy();
+    for (size_t i=0; i<n; i++) {
+        if (sol_solved[i] and sol_winner[i] == owner[i]) strategy[i] = _strategy[i];
+    }
+    winner = (winner - sol_solved) | (sol_winner & sol_solved);
+    solved |= sol_solved;
+
+    munmap(ptr, size);
+}
+
+void
+Game::write_sol_binary(std::ostream &os)
+{
+    psb_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, PSB_MAGIC, 8);
+    hdr.version = PSB_VERSION;
+    hdr.endian = PGB_ENDIAN;
+    hdr.n_nodes = n_nodes;
+    hdr.n_solved = solved.count();
+
+    static const char zeros[8] = { 0 };
+    auto write = [&] (const void *data, size_t len) {
+        os.write((const char*)data, len);
+        os.write(zeros, pgb_pad(len) - len);
+    };
+
+    write(&hdr, sizeof(hdr));
+    {
+        std::vector<bitset::block_type> blocks(solved.num_blocks());
+        boost::to_block_range(solved, blocks.begin());
+        write(blocks.data(), sizeof(bitset::block_type[blocks.size()]));
+        boost::to_block_range(winner & solved, blocks.begin());
+        write(blocks.data(), sizeof(bitset::block_type[blocks.size()]));
+    }
+    write(strategy, sizeof(int[n_nodes]));
+
+    if (!os) throw "unable to write binary solution";
+}
+
 void
 Game::parse_solution(std::istream &in)
 {
+    unshare_strategy();
+
     string line;
     while (getline(in, line)) {
         stringstream ss(line);
@@ -303,7 +935,7 @@ Game::parse_solution(std::istream &in)
             if (!(ss >> str)) throw "missing strategy for winning node";
 
             bool done = false;
-            for (auto o : out[ident]) {
+            for (auto o : out(ident)) {
                 if (o == str) {
                     strategy[ident] = o;
                     done = true;
@@ -316,97 +948,355 @@ Game::parse_solution(std::istream &in)
     }
 }
 
+/**
+ * Append the decimal representation of <value> to <buf>.
+ */
+static inline void
+append_int(std::string &buf, long long value)
+{
+    char tmp[24];
+    char *end = tmp + sizeof(tmp), *ptr = end;
+    unsigned long long v = value < 0 ? -(unsigned long long)value : value;
+    do { *--ptr = '0' + v % 10; v /= 10; } while (v != 0);
+    if (value < 0) *--ptr = '-';
+    buf.append(ptr, end - ptr);
+}
+
+/**
+ * Write the text of nodes 0 ... <count>-1, as appended to a buffer by <fun>(buf, node), to <os>.
+ * The nodes are formatted in chunks by up to <workers> threads (0 for autodetect) and written in order,
+ * one block per chunk. (No flush per line, no iostream formatting.)
+ */
+template <typename F>
+static void
+write_nodes(std::ostream &os, int count, int workers, const F &fun)
+{
+    const int chunk = 1<<16;
+    const int threads = thread_count(workers, count, chunk);
+    std::vector<std::string> bufs(threads);
+    for (int64_t first=0; first<count; first+=(int64_t)threads*chunk) {
+        run_threads(threads, [&] (int t) {
+            std::string &buf = bufs[t];
+            buf.clear();
+            const int from = (int)std::min(first + (int64_t)t*chunk, (int64_t)count);
+            const int to = (int)std::min((int64_t)from + chunk, (int64_t)count);
+            for (int i=from; i<to; i++) fun(buf, i);
+        });
+        for (auto &buf : bufs) os.write(buf.data(), buf.size());
+    }
+}
+
 void
-Game::write_pgsolver(std::ostream &os)
+Game::write_pgsolver(std::ostream &os, int workers)
 {
     // print banner
     os << "parity " << n_nodes << ";" << endl;
 
     // print nodes
-    for (int i=0; i<n_nodes; i++) {
-        os << i << " " << priority[i] << " " << owner[i];
-        for (unsigned j=0; j<out[i].size(); j++) {
-            if (j == 0) os << " ";
-            else os << ",";
-            os << out[i][j];
+    write_nodes(os, n_nodes, workers, [&] (std::string &buf, int i) {
+        append_int(buf, i);
+        buf += ' ';
+        append_int(buf, priority[i]);
+        buf += owner[i] ? " 1" : " 0";
+        bool first = true;
+        for (int to : out(i)) {
+            buf += first ? ' ' : ',';
+            append_int(buf, to);
+            first = false;
         }
-        if (label[i] != "") os << " \"" << label[i] << "\"";
-        os << ";" << endl;
-    }
+        if (label.size(i) != 0) {
+            buf += " \"";
+            buf.append(label.data(i), label.size(i));
+            buf += '\"';
+        }
+        buf += ";\n";
+    });
 }
 
 void
-Game::write_dot(std::ostream &out)
+Game::write_dot(std::ostream &out, int workers)
 {
     out << "digraph G {" << endl;
-    for (int i=0; i<n_nodes; i++) {
-        out << i << " [ shape=\"" << (owner[i] ? "box" : "diamond")
-            << "\", label=\"" << priority[i] << "\"];" << endl;
-        for (auto j : this->out[i]) {
-            out << i << " -> " << j << ";" << endl;
+    write_nodes(out, n_nodes, workers, [&] (std::string &buf, int i) {
+        append_int(buf, i);
+        buf += owner[i] ? " [ shape=\"box\", label=\"" : " [ shape=\"diamond\", label=\"";
+        append_int(buf, priority[i]);
+        buf += "\"];\n";
+        for (auto j : this->out(i)) {
+            append_int(buf, i);
+            buf += " -> ";
+            append_int(buf, j);
+            buf += ";\n";
         }
-    }
+    });
     out << "}" << endl;
 }
 
 void
-Game::write_sol(std::ostream &out)
+Game::write_sol(std::ostream &out, int workers)
 {
     // print banner
     out << "paritysol " << solved.count() << ";" << endl;
 
     // print solution
-    for (int i=0; i<n_nodes; i++) {
+    write_nodes(out, n_nodes, workers, [&] (std::string &buf, int i) {
         if (solved[i]) {
-            out << i << " " << (winner[i] ? "1" : "0");
-            if (strategy[i] != -1) out << " " << strategy[i];
-            out << ";" << endl;
+            append_int(buf, i);
+            buf += winner[i] ? " 1" : " 0";
+            if (strategy[i] != -1) {
+                buf += ' ';
+                append_int(buf, strategy[i]);
+            }
+            buf += ";\n";
+        }
+    });
+}
+
+bool
+Game::isSorted() const
+{
+    for (int i=1; i<n_nodes; i++) {
+        if ((unsigned int)priority[i-1] > (unsigned int)priority[i]) return false;
+    }
+    return true;
+}
+
+void
+Game::sorted_order(int *order, int workers) const
+{
+    unsigned int max_prio = 0;
+    for (int i=0; i<n_nodes; i++) max_prio = std::max(max_prio, (unsigned int)priority[i]);
+
+    const int threads = thread_count(workers, n_nodes, 1<<16);
+
+    // stable (LSD radix) counting sort by priority, with at most 16 bits per pass
+    const int bits = 32 - __builtin_clz(max_prio | 1);
+    const int passes = (bits + 15) / 16;
+    const int width = (bits + passes - 1) / passes;
+    const int buckets = 1 << width;
+
+    int *tmp = new int[n_nodes];
+    std::vector<int> hist((size_t)threads * buckets);
+
+    run_threads(threads, [&] (int t) {
+        int from, to;
+        thread_block(n_nodes, t, threads, &from, &to);
+        for (int i=from; i<to; i++) order[i] = i;
+    });
+
+    int *src = order, *dst = tmp;
+    for (int pass=0; pass<passes; pass++) {
+        const int shift = pass * width;
+        auto digit = [&] (int node) { return ((unsigned int)priority[node] >> shift) & (buckets-1); };
+
+        // every thread counts the digits in its part...
+        run_threads(threads, [&] (int t) {
+            int from, to;
+            thread_block(n_nodes, t, threads, &from, &to);
+            int *h = hist.data() + (size_t)t * buckets;
+            std::fill(h, h + buckets, 0);
+            for (int i=from; i<to; i++) h[digit(src[i])]++;
+        });
+
+        // ...then gets the first position of each digit for its part...
+        int sum = 0;
+        for (int b=0; b<buckets; b++) {
+            for (int t=0; t<threads; t++) {
+                const int count = hist[(size_t)t * buckets + b];
+                hist[(size_t)t * buckets + b] = sum;
+                sum += count;
+            }
         }
+
+        // ...and moves its part in order (so the sort is stable)
+        run_threads(threads, [&] (int t) {
+            int from, to;
+            thread_block(n_nodes, t, threads, &from, &to);
+            int *h = hist.data() + (size_t)t * buckets;
+            for (int i=from; i<to; i++) dst[h[digit(src[i])]++] = src[i];
+        });
+
+        std::swap(src, dst);
     }
+    if (src != order) memcpy(order, src, sizeof(int[n_nodes]));
+    delete[] tmp;
 }
 
 void
-Game::reindex(int *mapping)
+Game::locality_order(int *order, int workers) const
 {
+    sorted_order(order, workers);
+
+    // find the blocks of nodes with the same priority
+    std::vector<int> blocks;
+    for (int i=0; i<n_nodes; i++) {
+        if (i == 0 or priority[order[i]] != priority[order[i-1]]) blocks.push_back(i);
+    }
+    blocks.push_back(n_nodes);
+    const int n_blocks = blocks.size() - 1;
+
+    // every block is reordered by one thread; threads take the next block until all are done
+    const int threads = thread_count(workers, n_nodes, 1<<16);
+    std::vector<char> visited(n_nodes, 0);
+    int next = 0;
+
+    run_threads(threads, [&] (int) {
+        std::vector<int> queue;
+        while (true) {
+            const int b = __sync_fetch_and_add(&next, 1);
+            if (b >= n_blocks) break;
+            const int first = blocks[b], last = blocks[b+1];
+            if (last - first < 3) continue;
+
+            // breadth-first search from every unvisited node (in sorted order), within the block
+            const int p = priority[order[first]];
+            queue.clear();
+            for (int i=first; i<last; i++) {
+                const int start = order[i];
+                if (visited[start]) continue;
+                visited[start] = 1;
+                size_t head = queue.size();
+                queue.push_back(start);
+                while (head < queue.size()) {
+                    const int cur = queue[head++];
+                    for (int to : out(cur)) {
+                        if (priority[to] == p and !visited[to]) { visited[to] = 1; queue.push_back(to); }
+                    }
+                    for (int from : in(cur)) {
+                        if (priority[from] == p and !visited[from]) { visited[from] = 1; queue.push_back(from); }
+                    }
+                }
+            }
+            std::copy(queue.begin(), queue.end(), order + first);
+        }
+    });
+}
+
+void
+Game::reindex(int *mapping, int workers)
+{
+    // if the game is already sorted, keep the arrays (e.g. of a memory mapped game) as they are
+    if (isSorted()) {
+        if (mapping != NULL) for (int i=0; i<n_nodes; i++) mapping[i] = i;
+        return;
+    }
+
     int *index = mapping == NULL ? new int[n_nodes] : mapping;
-    for (int i=0; i<n_nodes; i++) index[i] = i;
-    std::sort(index, index+n_nodes, [&](const int &a, const int &b) { return (unsigned int)priority[a]<(unsigned int)priority[b]; });
-    // now index stores the reorder, all we need to do now is reorder in-place
+    sorted_order(index, workers);
+
+    // now index stores the reorder, get the permutation that applies it
+    const int threads = thread_count(workers, n_nodes, 1<<16);
     int *inv = new int[n_nodes];
-    for (int i=0; i<n_nodes; i++) inv[index[i]] = i;
+    run_threads(threads, [&] (int t) {
+        int from, to;
+        thread_block(n_nodes, t, threads, &from, &to);
+        for (int i=from; i<to; i++) inv[index[i]] = i;
+    });
     if (index != mapping) delete[] index;
     // apply the permutation
-    permute(inv);
+    permute(inv, workers);
     delete[] inv;
 }
 
 void
-Game::permute(int *mapping)
+Game::permute(int *mapping, int workers)
 {
-    // first apply reorder to "in" and "out"
-    for (int i=0; i<n_nodes; i++) {
-        for (auto it = in[i].begin(); it != in[i].end(); it++) *it = mapping[*it];
-        for (auto it = out[i].begin(); it != out[i].end(); it++) *it = mapping[*it];
-        if (strategy[i] != -1) strategy[i] = mapping[strategy[i]];
+    // nothing to do for the identity permutation
+    bool identity = true;
+    for (int i=0; i<n_nodes and identity; i++) identity = mapping[i] == i;
+    if (identity) return;
+
+    Game *res = permuted_copy(mapping, workers);
+    swap(*res);
+    delete res;
+}
+
+Game*
+Game::permuted_copy(const int *mapping, int workers) const
+{
+    const int threads = thread_count(workers, n_nodes, 1<<16);
+
+    Game *res = new Game(n_nodes);
+    res->n_edges = n_edges;
+
+    int *inv = new int[n_nodes];
+    run_threads(threads, [&] (int t) {
+        int from, to;
+        thread_block(n_nodes, t, threads, &from, &to);
+        for (int i=from; i<to; i++) inv[mapping[i]] = i;
+    });
+
+    // gather the edges into new arrays in the new order
+    {
+        edge_offset *new_outa = res->outa;
+        edge_offset *new_ina = res->ina;
+
+        run_threads(threads, [&] (int t) {
+            int from, to;
+            thread_block(n_nodes, t, threads, &from, &to);
+            for (int i=from; i<to; i++) {
+                new_outa[i] = out(inv[i]).size();
+                new_ina[i] = in(inv[i]).size();
+            }
+        });
+
+        prefix_sum(new_outa, n_nodes, threads);
+        prefix_sum(new_ina, n_nodes, threads);
+
+        free_array(res->outs);
+        free_array(res->ins);
+        int *new_outs = res->outs = alloc_array<int>(new_outa[n_nodes]);
+        int *new_ins = res->ins = alloc_array<int>(new_ina[n_nodes]);
+
+        run_threads(threads, [&] (int t) {
+            int from, to;
+            thread_block(n_nodes, t, threads, &from, &to);
+            for (int i=from; i<to; i++) {
+                const int k = inv[i];
+                int *_new_out = new_outs + new_outa[i];
+                int *_new_in = new_ins + new_ina[i];
+                for (int n : out(k)) *_new_out++ = mapping[n];
+                for (int n : in(k)) *_new_in++ = mapping[n];
+                *_new_out = -1;
+                *_new_in = -1;
+            }
+        });
     }
-    // now swap nodes until done
-    for (int i=0; i<n_nodes; i++) {
-        for (;;) {
-            int k = mapping[i];
-            if (k == i) break;
-            // swap i and mapping[i]
-            std::swap(priority[i], priority[k]);
-            { bool b = owner[k]; owner[k] = owner[i]; owner[i] = b; }
-            std::swap(in[i], in[k]);
-            std::swap(out[i], out[k]);
-            std::swap(label[i], label[k]);
-            { bool b = solved[k]; solved[k] = solved[i]; solved[i] = b; }
-            { bool b = winner[k]; winner[k] = winner[i]; winner[i] = b; }
-            std::swap(strategy[i], strategy[k]);
-            mapping[i] = mapping[k];
-            mapping[k] = k;
-        }
+
+    // gather the nodes (the bitsets per 64 nodes, so threads never share a block)
+    {
+        const size_t n_blocks = owner.num_blocks();
+        std::vector<bitset::block_type> new_owner(n_blocks, 0), new_solved(n_blocks, 0), new_winner(n_blocks, 0);
+        const int block_bits = bitset::bits_per_block;
+
+        const int block_threads = (int)std::min((size_t)threads, n_blocks);
+        run_threads(block_threads, [&] (int t) {
+            int from, to;
+            thread_block(n_blocks, t, block_threads, &from, &to);
+            to = std::min(to * block_bits, n_nodes);
+            for (int i=from*block_bits; i<to; i++) {
+                const int k = inv[i];
+                const bitset::block_type bit = (bitset::block_type)1 << (i % block_bits);
+                res->priority[i] = priority[k];
+                res->strategy[i] = strategy[k] == -1 ? -1 : mapping[strategy[k]];
+                if (owner[k]) new_owner[i / block_bits] |= bit;
+                if (solved[k]) new_solved[i / block_bits] |= bit;
+                if (winner[k]) new_winner[i / block_bits] |= bit;
+            }
+        });
+
+        boost::from_block_range(new_owner.begin(), new_owner.end(), res->owner);
+        boost::from_block_range(new_solved.begin(), new_solved.end(), res->solved);
+        boost::from_block_range(new_winner.begin(), new_winner.end(), res->winner);
+    }
+
+    // copy the labels, if any, into the pool of the copy
+    if (!label.empty()) {
+        for (int i=0; i<n_nodes; i++) res->label.set(i, label.data(inv[i]), label.size(inv[i]));
     }
+
+    delete[] inv;
+    return res;
 }
 
 int
@@ -414,6 +1304,7 @@ Game::inflate()
 {
     // assumption: reindex has been called first!!!
     if (n_nodes == 0) return 0;
+    unshare();
     int d = 1;
 
     // reassign priorities and reindex nodes
@@ -434,6 +1325,7 @@ Game::compress()
 {
     // assumption: reindex has been called first!!!
     if (n_nodes == 0) return 0;
+    unshare();
     int d = 1;
 
     // reassign priorities and reindex nodes
@@ -453,6 +1345,7 @@ Game::renumber()
 {
     // assumption: reindex has been called first!!!
     if (n_nodes == 0) return 0;
+    unshare();
     int d = 1;
 
     // reassign priorities and reindex nodes
@@ -473,6 +1366,7 @@ void
 Game::evenodd()
 {
     // assumption: reindex has been called first!!!
+    unshare();
 
     // reassign priorities and reindex nodes
     int prio = -1, last = -1;
@@ -493,6 +1387,7 @@ void
 Game::minmax()
 {
     // assumption: reindex has been called first!!!
+    unshare();
 
     // reassign priorities and reindex nodes
     int prio = -1, last = -1;
@@ -509,6 +1404,8 @@ Game::minmax()
 Game *
 Game::extract_subgame(std::vector<int> &selection, int *mapping)
 {
+    build();
+
     // order selection
     sort(selection.begin(), selection.end());
 
@@ -527,7 +1424,7 @@ Game::extract_subgame(std::vector<int> &selection, int *mapping)
     // count number of successors in selection for every vertex
     for (int i : selection) {
         int count = 0;
-        for (int j : out[i]) if (inv[j] != -1) count++;
+        for (int j : out(i)) if (inv[j] != -1) count++;
         inv[i] = count;
         if (count == 0) q.push_back(i);
     }
@@ -537,7 +1434,7 @@ Game::extract_subgame(std::vector<int> &selection, int *mapping)
         int i = q.back();
         q.pop_back();
         inv[i] = -1;
-        for (int j : in[i]) {
+        for (int j : in(i)) {
             if (inv[j] != -1 and --inv[j] == 0) q.push_back(j);
         }
     }
@@ -553,29 +1450,72 @@ Game::extract_subgame(std::vector<int> &selection, int *mapping)
 
     // construct subgame
     Game* res = new Game(counter);
+    res->unbuild();
 
     // create nodes of subgame
     for (int i=0; i<counter; i++) {
         int k = map[i];
         res->priority[i] = priority[k];
         res->owner[i] = owner[k];
-        res->label[i] = label[k];
+        res->label.set(i, label.data(k), label.size(k));
         res->solved[i] = solved[k];
         res->winner[i] = winner[k];
         res->strategy[i] = strategy[k];
-        for (auto j : in[k]) {
-            if (inv[j] != -1) res->in[i].push_back(inv[j]);
+        for (auto j : in(k)) {
+            if (inv[j] != -1) res->vin[i].push_back(inv[j]);
         }
-        for (auto j : out[k]) {
-            if (inv[j] != -1) res->out[i].push_back(inv[j]);
+        for (auto j : out(k)) {
+            if (inv[j] != -1) {
+                res->vout[i].push_back(inv[j]);
+                res->n_edges++;
+            }
         }
     }
+    res->build();
 
     if (mapping == NULL) delete[] map;
     delete[] inv;
     return res;
 }
 
+Game*
+Game::local_subgame(const int *nodes, int count, int *local) const
+{
+    for (int i=0; i<count; i++) local[nodes[i]] = i;
+
+    Game *res = new Game(count);
+
+    // count the edges within the selection
+    for (int i=0; i<count; i++) {
+        const int k = nodes[i];
+        res->outa[i] = std::count_if(out(k).begin(), out(k).end(), [&] (const int n) { return local[n] != -1; });
+        res->ina[i] = std::count_if(in(k).begin(), in(k).end(), [&] (const int n) { return local[n] != -1; });
+    }
+    prefix_sum(res->outa, count, 1);
+    prefix_sum(res->ina, count, 1);
+    res->n_edges = res->outa[count] - count;
+
+    free_array(res->outs);
+    free_array(res->ins);
+    res->outs = alloc_array<int>(res->outa[count]);
+    res->ins = alloc_array<int>(res->ina[count]);
+
+    for (int i=0; i<count; i++) {
+        const int k = nodes[i];
+        res->priority[i] = priority[k];
+        res->owner[i] = owner[k];
+        int *_out = res->outs + res->outa[i];
+        int *_in = res->ins + res->ina[i];
+        for (int n : out(k)) if (local[n] != -1) *_out++ = local[n];
+        for (int n : in(k)) if (local[n] != -1) *_in++ = local[n];
+        *_out = -1;
+        *_in = -1;
+    }
+
+    for (int i=0; i<count; i++) local[nodes[i]] = -1;
+    return res;
+}
+
 Game&
 Game::operator=(const Game &other)
 {
@@ -591,12 +1531,20 @@ Game::swap(Game &other)
     std::swap(n_edges, other.n_edges);
     std::swap(priority, other.priority);
     std::swap(owner, other.owner);
-    std::swap(label, other.label);
-    std::swap(out, other.out);
-    std::swap(in, other.in);
+    label.swap(other.label);
+    std::swap(outa, other.outa);
+    std::swap(ina, other.ina);
+    std::swap(outs, other.outs);
+    std::swap(ins, other.ins);
+    std::swap(vout, other.vout);
+    std::swap(vin, other.vin);
     std::swap(solved, other.solved);
     std::swap(winner, other.winner);
     std::swap(strategy, other.strategy);
+    std::swap(mapped, other.mapped);
+    std::swap(mapped_size, other.mapped_size);
+    std::swap(refs, other.refs);
+    std::swap(strategy_refs, other.strategy_refs);
 }
 
 void
@@ -604,6 +1552,7 @@ Game::reset()
 {
     solved.reset();
     winner.reset();
+    unshare_strategy();
     memset(strategy, -1, sizeof(int[n_nodes]));
 }
 
@@ -17,16 +17,136 @@
 #ifndef GAME_HPP
 #define GAME_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <sstream>
 #include <vector>
 #include <map>
 
 #include <boost/dynamic_bitset.hpp>
 
+#include "alloc.hpp"
+
 namespace pg {
 
 typedef boost::dynamic_bitset<unsigned long long> bitset;
 
+/**
+ * Index into the CSR edge arrays <outs> and <ins> (64-bit, so games can have more than 2^31 edges).
+ * Node ids are 32-bit.
+ */
+typedef int64_t edge_offset;
+
+/**
+ * Read-only range over the successors or predecessors of a node.
+ * Either a -1 terminated slice of a CSR edge array, or a [first,last) range in a builder vector.
+ * (For terminated slices, iteration stops at the first -1.)
+ */
+class edge_range
+{
+public:
+    class iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef int value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const int* pointer;
+        typedef const int& reference;
+
+        iterator(const int *ptr) : ptr(ptr) { }
+        inline const int& operator*() const { return *ptr; }
+        inline iterator& operator++() { ++ptr; return *this; }
+        inline iterator operator++(int) { iterator res(ptr); ++ptr; return res; }
+        inline bool operator!=(const iterator &other) const { return ptr != other.ptr and *ptr != -1; }
+        inline bool operator==(const iterator &other) const { return !(*this != other); }
+
+    protected:
+        const int *ptr;
+    };
+
+    edge_range(const int *first, const int *last=NULL) : first(first), last(last) { }
+
+    inline iterator begin() const { return iterator(first); }
+    inline iterator end() const { return iterator(last); }
+    inline int operator[](size_t idx) const { return first[idx]; }
+    inline bool empty() const { return first == last or *first == -1; }
+
+    /**
+     * Count the number of edges in the range.
+     */
+    inline size_t size() const
+    {
+        size_t count = 0;
+        for (const int *ptr = first; ptr != last and *ptr != -1; ptr++) count++;
+        return count;
+    }
+
+protected:
+    const int *first;
+    const int *last;
+};
+
+/**
+ * The (optional) labels of the nodes of a game, stored in one string pool with an offset per node.
+ * Nothing is allocated until a non-empty label is set.
+ * Copies share the pool until one of them sets a label (copy-on-write).
+ */
+class label_pool
+{
+public:
+    label_pool(int count=0) : count(count) { }
+
+    /**
+     * Returns whether no node has a label.
+     */
+    inline bool empty() const { return store == nullptr; }
+
+    /**
+     * Get the label of node <node> (<size> characters, not terminated).
+     */
+    inline const char *data(int node) const { return empty() ? "" : store->pool.data() + store->spans[node].first; }
+    inline size_t size(int node) const { return empty() ? 0 : store->spans[node].second; }
+    inline std::string get(int node) const { return std::string(data(node), size(node)); }
+
+    /**
+     * Set the label of node <node>. (The space of a replaced label is not reused.)
+     */
+    inline void set(int node, const char *label, size_t len)
+    {
+        if (empty()) {
+            if (len == 0) return;
+            store = std::make_shared<storage>();
+            store->spans.resize(count, std::make_pair((size_t)0, (size_t)0));
+        } else if (store.use_count() > 1) {
+            store = std::make_shared<storage>(*store);
+        }
+        store->spans[node] = std::make_pair(store->pool.size(), len);
+        store->pool.append(label, len);
+    }
+
+    inline void set(int node, const std::string &label) { set(node, label.data(), label.size()); }
+
+    inline void swap(label_pool &other)
+    {
+        std::swap(count, other.count);
+        store.swap(other.store);
+    }
+
+protected:
+    struct storage
+    {
+        std::string pool;                               // all labels
+        std::vector<std::pair<size_t, size_t>> spans;   // offset and length of each label
+    };
+
+    int count;                                          // number of nodes
+    std::shared_ptr<storage> store;                     // NULL if no labels
+};
+
 class Game
 {
 public:
@@ -36,12 +156,15 @@ public:
     Game();
 
     /**
-     * Construct a new parity game for <count> nodes.
+     * Construct a new parity game for <count> nodes (without edges).
      */
     Game(int count);
 
     /**
      * Construct a copy of an existing parity game.
+     * The copy shares the priorities, labels and edge arrays with <other> (see unshare),
+     * and the strategy (see unshare_strategy), and only copies the owners, <solved> and <winner>.
+     * (Games that are not built are copied completely.)
      */
     Game(const Game& other);
 
@@ -68,51 +191,182 @@ public:
     /**
      * Add an edge from <from> to <to>.
      * Returns true if the edge was added or false if it already existed.
+     * (If the edge arrays are built, this first moves the edges back to the builder vectors.)
+     * (Checking for duplicates is linear in the degree; use GameBuilder to add many edges.)
      */
     bool addEdge(int from, int to);
 
     /**
      * Remove an edge from <from> to <to>.
      * Returns true if the edge was removed or false if it did not exist.
+     * (If the edge arrays are built, the edge is removed in-place.)
      */
     bool removeEdge(int from, int to);
 
+    /**
+     * Returns whether the priorities and edge arrays are shared with a copy of the game.
+     */
+    inline bool isShared() const { return *refs > 1; }
+
+    /**
+     * Make a private copy of the priorities and edge arrays if they are shared with a copy of the game.
+     * All methods that modify them call this first; do the same before writing to them directly.
+     */
+    void unshare(void);
+
+    /**
+     * Make a private copy of <strategy> if it is shared with a copy of the game.
+     * All methods that modify it call this first; do the same before writing to it directly.
+     */
+    void unshare_strategy(void);
+
+    /**
+     * Replace <priority> and the edge arrays by arrays with the same contents (allocated with alloc_array),
+     * e.g. copies that are placed differently in memory. The old arrays are released (or no longer shared).
+     */
+    void replace_arrays(int *priority, edge_offset *outa, edge_offset *ina, int *outs, int *ins);
+
+    /**
+     * Move the edges from the builder vectors into the CSR arrays <outa>, <ina>, <outs>, <ins>.
+     * Does nothing if the edge arrays are already built.
+     */
+    void build(void);
+
+    /**
+     * Move the edges from the CSR arrays back into the builder vectors.
+     * Does nothing if the game is not built.
+     */
+    void unbuild(void);
+
+    /**
+     * Returns whether the edges are stored in the CSR arrays.
+     */
+    inline bool isBuilt() const { return vout == NULL; }
+
+    /**
+     * Get the successors of node <node>.
+     */
+    inline edge_range out(int node) const
+    {
+        if (vout == NULL) return edge_range(outs + outa[node]);
+        else return edge_range(vout[node].data(), vout[node].data() + vout[node].size());
+    }
+
+    /**
+     * Get the predecessors of node <node>.
+     */
+    inline edge_range in(int node) const
+    {
+        if (vin == NULL) return edge_range(ins + ina[node]);
+        else return edge_range(vin[node].data(), vin[node].data() + vin[node].size());
+    }
+
     /**
      * Parse a pgsolver game.
+     * (Seekable streams are read at once and parsed with the buffer parser.)
      */
     void parse_pgsolver(std::istream &in);
 
+    /**
+     * Load a game in the binary format (.pgb) by mapping the file into memory.
+     * The priorities and edge arrays are used in-place (copy-on-write), not copied.
+     */
+    void load_binary(const char *filename);
+
+    /**
+     * Parse a pgsolver game from the buffer <data> of <len> bytes with <workers> threads (0 for autodetect).
+     * The input is split at line ends after a ';'; the predecessors of each node are sorted by id.
+     */
+    void parse_pgsolver(const char *data, size_t len, int workers=0);
+
+    /**
+     * Parse a pgsolver game that is delivered in consecutive blocks by <next>, which returns false at the end.
+     * Every block is parsed when it arrives, so producing the next block (e.g. decompressing) can overlap parsing.
+     * Uses <workers> threads (0 for autodetect) to construct the edge arrays.
+     */
+    void parse_pgsolver(const std::function<bool(std::string&)> &next, int workers=0);
+
+    /**
+     * Parse an (uncompressed) pgsolver game file with the parallel parser, see parse_pgsolver.
+     */
+    void load_pgsolver(const char *filename, int workers=0);
+
     /**
      * Parse a [full or partial] pgsolver solution.
      */
     void parse_solution(std::istream &in);
 
+    /**
+     * Load a [full or partial] solution in the binary solution format by mapping the file into memory.
+     * Performs the same checks as parse_solution.
+     */
+    void load_solution_binary(const char *filename);
+
+    /**
+     * Write the solution in the binary solution format (solved and winner bitmaps, strategy array).
+     */
+    void write_sol_binary(std::ostream &out);
+
     /**
      * Write the game in pgsolver format.
+     * (Lines are formatted in blocks, by up to <workers> threads, 0 for autodetect.)
      */
-    void write_pgsolver(std::ostream &out);
+    void write_pgsolver(std::ostream &out, int workers=1);
+
+    /**
+     * Write the game in the binary format (.pgb).
+     * (Node labels are not stored.)
+     */
+    void write_binary(std::ostream &out);
 
     /**
      * Write the game as a DOT graph.
+     * (Lines are formatted in blocks, by up to <workers> threads, 0 for autodetect.)
      */
-    void write_dot(std::ostream &out);
+    void write_dot(std::ostream &out, int workers=1);
 
     /**
      * Write the solution in pgsolver format.
+     * (Lines are formatted in blocks, by up to <workers> threads, 0 for autodetect.)
      */
-    void write_sol(std::ostream &cout);
+    void write_sol(std::ostream &cout, int workers=1);
 
     /**
-     * Sort the nodes in order of priority (low to high).
+     * Returns whether the nodes are in order of priority (low to high).
+     */
+    bool isSorted() const;
+
+    /**
+     * Compute the order of the nodes by priority (low to high, stable) without moving them.
+     * Afterwards, <order[i]> is the node at position <i> (<order> must be int[n_nodes]).
+     */
+    void sorted_order(int *order, int workers = 0) const;
+
+    /**
+     * Compute an order of the nodes by priority (low to high) like sorted_order, but with the nodes
+     * of each priority in breadth-first order of the edges (in either direction) between them.
+     * Nodes that are connected then get nearby indices, which improves the locality of attractor loops.
+     */
+    void locality_order(int *order, int workers = 0) const;
+
+    /**
+     * Sort the nodes in order of priority (low to high), with a stable counting sort.
      * Afterwards, <mapping> is such that node <i> was originally at <mapping[i]>.
+     * Uses up to <workers> threads (0 for autodetect) on large games.
      */
-    void reindex(int *mapping = NULL);
+    void reindex(int *mapping = NULL, int workers = 0);
 
     /**
      * Apply a permutation, moving node <i> to position <mapping[i]>.
      * This reverses a reindex operation.
+     * Uses up to <workers> threads (0 for autodetect) on large games.
+     */
+    void permute(int *mapping, int workers = 0); // undo reindex
+
+    /**
+     * Create a copy of the game with node <i> at position <mapping[i]>; the game itself is unchanged.
      */
-    void permute(int *mapping); // undo reindex
+    Game *permuted_copy(const int *mapping, int workers = 0) const;
 
     /**
      * Reassign priorities such that every node has a unique priority.
@@ -170,7 +424,7 @@ public:
     inline void edge_recount()
     {
         n_edges = 0;
-        for (int n=0; n<n_nodes; n++) n_edges += out[n].size();
+        for (int n=0; n<n_nodes; n++) n_edges += out(n).size();
     }
 
     /**
@@ -181,6 +435,15 @@ public:
      */
     Game *extract_subgame(std::vector<int> &selection, int *mapping=NULL);
 
+    /**
+     * Create a new (built) Game of the <count> nodes in <nodes>, which are in ascending order,
+     * where node <nodes[i]> becomes node <i> and only the edges between these nodes are kept.
+     * The work only depends on the number of nodes and their edges: <local> must have an entry
+     * for every node of this game, all -1, which are restored to -1 before returning.
+     * (We don't check if the relation is total.)
+     */
+    Game *local_subgame(const int *nodes, int count, int *local) const;
+
     /**
      * Reset <solved>, <winner> and <strategy>.
      */
@@ -201,16 +464,93 @@ public:
      */
 
     int n_nodes;           // number of nodes
-    int n_edges;           // number of edges
+    size_t n_edges;        // number of edges
     int *priority;         // priority of each node
     bitset owner;          // owner of each node (1 for odd, 0 for even)
-    std::string *label;    // (optional) node labels
-    std::vector<int> *out; // outgoing edges
-    std::vector<int> *in;  // incoming edges
+    label_pool label;      // (optional) node labels
+
+    edge_offset *outa;     // index of the first successor of each node in <outs> (n_nodes+1 entries)
+    edge_offset *ina;      // index of the first predecessor of each node in <ins> (n_nodes+1 entries)
+    int *outs;             // all successors, the list of each node is terminated by -1
+    int *ins;              // all predecessors, the list of each node is terminated by -1
+
+    std::vector<int> *vout; // (builder) outgoing edges, NULL when built
+    std::vector<int> *vin;  // (builder) incoming edges, NULL when built
 
     bitset solved;         // set true if node solved
     bitset winner;         // for solved vertices, set 1 if won by 1, else 0
-    int *strategy;         // strategy for winning vertices
+    int *strategy;         // strategy for winning vertices (shared with copies, see unshare_strategy)
+
+    char *mapped;          // (optional) memory mapped binary game backing <priority> and the edge arrays
+    size_t mapped_size;    // size of the memory mapped binary game
+    int *refs;             // number of games sharing <priority>, the edge arrays and <mapped>
+    int *strategy_refs;    // number of games sharing <strategy>
+
+protected:
+    /**
+     * Free an array of the game (see alloc_array), unless it is part of the memory mapped file.
+     */
+    template <typename T>
+    inline void release(T *arr)
+    {
+        if (mapped != NULL and (char*)arr >= mapped and (char*)arr < mapped + mapped_size) return;
+        free_array(arr);
+    }
+
+    /**
+     * Drop this reference to <priority>, the edge arrays and <mapped>; free them if it was the last one.
+     */
+    void release_shared(void);
+
+    /**
+     * Drop this reference to <strategy>; free it if it was the last one.
+     */
+    void release_strategy(void);
+};
+
+/**
+ * Builds a Game from edges that are given in bulk.
+ * Unlike Game::addEdge, adding an edge does not check for duplicates; build() removes them
+ * by grouping the edges per source node and sorting each group, then creates the edge arrays at once.
+ */
+class GameBuilder
+{
+public:
+    /**
+     * Start building a game with <count> nodes.
+     */
+    GameBuilder(int count);
+
+    /**
+     * Initialize a node <node> with given <priority>, <owner> and <label>.
+     */
+    void initNode(int node, int priority, int owner, std::string label="");
+
+    /**
+     * Add an edge from <from> to <to>.
+     */
+    inline void addEdge(int from, int to) { edges.push_back(std::make_pair(from, to)); }
+
+    /**
+     * Add the edges from <from> to each of the <count> nodes in <to>.
+     */
+    void addEdges(int from, const int *to, size_t count);
+
+    /**
+     * Add the (from,to) edges in <edges>.
+     */
+    void addEdges(const std::vector<std::pair<int, int>> &edges);
+
+    /**
+     * Move the game into <game>, after removing duplicate edges and building the CSR arrays.
+     * The successors and predecessors of each node are sorted by id.
+     * (The builder is empty afterwards.)
+     */
+    void build(Game &game);
+
+protected:
+    Game game;                                 // the nodes (without edges)
+    std::vector<std::pair<int, int>> edges;    // all (from,to) edges, possibly with duplicates
 };
 
 }
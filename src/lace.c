@@ -55,6 +55,14 @@ static size_t default_dqsize = 100000;
  */
 static int verbosity = 0;
 
+/**
+ * Pinning flag (without hwloc), set with lace_set_pinning, and the processors to pin to
+ */
+static int pin_workers = 0;
+#if !LACE_USE_HWLOC && defined(__linux__)
+static cpu_set_t pin_cpus;
+#endif
+
 /**
  * Number of workers and number of enabled/active workers
  */
@@ -389,6 +397,24 @@ lace_pin_worker(void)
 
     // Check if everything is on the correct node
     lace_check_memory();
+#elif defined(__linux__)
+    if (!pin_workers) return;
+
+    // Select the processor of our worker (round robin)
+    unsigned int worker = lace_get_worker()->worker;
+    int count = CPU_COUNT(&pin_cpus);
+    if (count == 0) return;
+    int idx = worker % count, cpu = -1;
+    for (int i=0; i<=idx; i++) do cpu++; while (!CPU_ISSET(cpu, &pin_cpus));
+
+    // Pin our thread...
+    cpu_set_t cs;
+    CPU_ZERO(&cs);
+    CPU_SET(cpu, &cs);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cs), &cs) != 0) {
+        fprintf(stderr, "Lace warning: pthread_setaffinity_np failed!\n");
+    }
+    lace_get_worker()->pu = cpu;
 #endif
 }
 
@@ -812,6 +838,15 @@ lace_set_verbosity(int level)
     verbosity = level;
 }
 
+/**
+ * Set whether to pin workers (without hwloc).
+ */
+void
+lace_set_pinning(int pin)
+{
+    pin_workers = pin;
+}
+
 /**
  * Initialize Lace for work-stealing with <n> workers, where
  * each worker gets a task deque with <dqsize> elements.
@@ -836,6 +871,12 @@ lace_init(unsigned int _n_workers, size_t dqsize)
     unsigned int n_pus = sysconf(_SC_NPROCESSORS_ONLN);
 #endif
 
+#if !LACE_USE_HWLOC && defined(__linux__)
+    // Remember the processors we may run on (before any worker is pinned)
+    CPU_ZERO(&pin_cpus);
+    sched_getaffinity(0, sizeof(pin_cpus), &pin_cpus);
+#endif
+
     // Initialize globals
     n_workers = _n_workers == 0 ? n_pus : _n_workers;
     enabled_workers = n_workers;
@@ -88,6 +88,14 @@ LACE_TYPEDEF_CB(void, lace_startup_cb, void*);
  */
 void lace_set_verbosity(int level);
 
+/**
+ * Set whether to pin worker <i> to the <i>-th processor that the process may run on (round robin).
+ * This is used when Lace is compiled without hwloc (with hwloc, workers are always pinned).
+ * Call this before lace_init.
+ * Default: 0
+ */
+void lace_set_pinning(int pin);
+
 /**
  * Initialize Lace for <n_workers> workers with a deque size of <dqsize> per worker.
  * If <n_workers> is set to 0, automatically detects available cores.
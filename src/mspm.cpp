@@ -155,7 +155,7 @@ MSPMSolver::lift(int node, int target)
                 if (pl_max) best_ch1 = target;
                 else best_ch0 = target;
             }
-       } else for (int to : out[node]) {
+       } else for (int to : out(node)) {
             if (cover[to] == -2) continue;
             Prog(tmp, pms + k*to, d, pl_max);
 
@@ -178,7 +178,7 @@ MSPMSolver::lift(int node, int target)
         if (trace >= 2) logger << "computing min" << std::endl;
         if (trace >= 2) pm_copy(tmp, pm, 1-pl_min);
         int best_to = -1;
-        for (int to : out[node]) {
+        for (int to : out(node)) {
             if (cover[to] == -2) continue;
             Prog(tmp, pms + k*to, d, pl_min);
 
@@ -250,13 +250,13 @@ MSPMSolver::solve(int node, int str)
     while (!q.empty()) {
         int n = q.front();
         q.pop();
-        for (int from : in[n]) {
+        for (int from : in(n)) {
             // logger << "trying edge " << from << "/" << priority[from] << " to " << n << std::endl;
             if (cover[from]) continue;
             if (priority[from] > priority[node]) continue;
             if (owner[from] != pl) {
                 bool escapes = false;
-                for (int to : out[from]) {
+                for (int to : out(from)) {
                     if (cover[to] < 0) continue; // disabled or already solved
                     // if (cover[to] != 0) LOGIC_ERROR; // should have been covered
                     // ^--- it can escape, happens when alternating!
@@ -300,11 +300,11 @@ MSPMSolver::coverlower(int node, int k)
         if (cover[n]) continue; // also for "disabled"
         if (priority[n] <= pr) continue; // skip nodes of same priority
         cover[n] = k;
-        for (int from : in[n]) {
+        for (int from : in(n)) {
             if (cover[from]) continue;
             if (owner[from] != pl) {
                 bool escapes = false;
-                for (int to : out[from]) {
+                for (int to : out(from)) {
                     if (cover[to]) continue;
                     escapes = true;
                     break;
@@ -324,11 +324,11 @@ MSPMSolver::coverlower(int node, int k)
     while (!q.empty()) {
         int n = q.front();
         q.pop();
-        for (int from : in[n]) {
+        for (int from : in(n)) {
             if (cover[from]) continue;
             if (owner[from] != pl) {
                 bool escapes = false;
-                for (int to : out[from]) {
+                for (int to : out(from)) {
                     if (cover[to]) continue;
                     escapes = true;
                     break;
@@ -393,7 +393,7 @@ MSPMSolver::run()
     for (int n=n_nodes-1; n>=0; n--) {
         bool lifted = cover[n] == 0 and lift(n, -1);
         if (cover[n] == -1 or lifted) {
-            for (int from : in[n]) {
+            for (int from : in(n)) {
                 if (cover[from] == 0 and lift(from, n)) todo_push(from);
             }
         }
@@ -406,7 +406,7 @@ MSPMSolver::run()
     while (!todo.empty()) {
         int n = todo_pop();
         if (cover[n] == -1 or cover[n] == 0) {
-            for (int from : in[n]) {
+            for (int from : in(n)) {
                 if (cover[from] == 0 and lift(from, n)) todo_push(from);
             }
         }
@@ -424,7 +424,7 @@ MSPMSolver::run()
                 // try to see if it is attracted
                 const int pl = owner[n];
                 bool escapes = false;
-                for (int to : out[n]) {
+                for (int to : out(n)) {
                     if (game->solved[to]) {
                         if (game->winner[to] == pl) {
                             oink->solve(n, pl, to);
@@ -461,11 +461,11 @@ MSPMSolver::run()
                 q.pop();
                 if (!game->solved[n]) LOGIC_ERROR;
                 const bool pl = game->winner[n];
-                for (int from : in[n]) {
+                for (int from : in(n)) {
                     if (cover[from]) continue;
                     if (owner[from] != pl) {
                         bool escapes = false;
-                        for (int to : out[from]) {
+                        for (int to : out(from)) {
                             if (cover[to] < 0) continue;
                             if (cover[to] != 0) LOGIC_ERROR;
                             escapes = true;
@@ -37,6 +37,15 @@ NPPSolver::NPPSolver(Oink * oink, Game * game) :
     R.resize(n_nodes);
     T.resize(n_nodes);
     E.resize(n_nodes);
+
+    /* vv Stack initialization vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv */
+    Phase.push_back(true);
+    Supgame.push_back(&outgame);
+    Heads.push_back(new uideque());
+    Exits.push_back(new bitset(n_nodes));
+    Entries.push_back(new uidlist());
+    Entries[0]->push_front(std::move(uideque()));
+    /* ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ */
 }
 
 NPPSolver::~NPPSolver()
@@ -566,13 +575,10 @@ _INLINE_ void NPPSolver::search()
 void NPPSolver::run()
 {
 
-    /* vv Stack initialization vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv */
-    Phase.push_back(true);
-    Supgame.push_back(&outgame);
-    Heads.push_back(new uideque());
-    Exits.push_back(new bitset(n_nodes));
-    Entries.push_back(new uidlist());
-    Entries[0]->push_front(std::move(uideque()));
+    /* vv Reset of the regions and statistics of a previous run vvvvvvvvvvvvvvv */
+    outgame.reset();
+    winzero.reset();
+    totqueries = totpromos = maxqueries = maxpromos = doms = 0;
     /* ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ */
 
     /* vv Initialization of pos and maxprio vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv */
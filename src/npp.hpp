@@ -50,6 +50,10 @@ public:
     // Main solver function
     virtual void run();
 
+    // Solve again, reusing the stack (run only resets the regions, which are bitsets,
+    // and initializes the nodes up to the highest enabled node, like a new solve)
+    virtual bool resolve() { run(); return true; }
+
     /******************************************************************************/
 
 protected:
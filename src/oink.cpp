@@ -16,6 +16,9 @@
 
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
 #include <queue>
 #include <stack>
 #include <iostream>
@@ -24,245 +27,347 @@
 #include "solvers.hpp"
 #include "solver.hpp"
 #include "lace.h"
+#include "parallel.hpp"
 
 namespace pg {
 
 Oink::Oink(Game &game, std::ostream &out) : game(&game), logger(out), todo(game.n_nodes), disabled(game.n_nodes)
 {
-    // initialize outcount (for flush/attract)
+    // solvers and preprocessing use the CSR edge arrays
+    game.build();
+
     outcount = new int[game.n_nodes];
-    for (int i=0; i<game.n_nodes; i++) {
-        outcount[i] = std::count_if(game.out[i].begin(), game.out[i].end(),
-                [&] (const int n) { return disabled[n] == 0; });
+    prepare(game);
+}
+
+int
+Oink::threads(size_t count)
+{
+    // workers -1 (the default) means sequential
+    return workers < 0 ? 1 : thread_count(workers, count, 1<<16);
+}
+
+void
+Oink::prepare(Game &game)
+{
+    if (input != NULL) {
+        delete this->game;
+        delete[] order;
+        input = NULL;
+        order = NULL;
+    }
+    this->game = &game;
+
+    // Oink writes the solution to <game> (at the end, if it solves a sorted copy)
+    game.unshare_strategy();
+
+    // solvers and preprocessing need the nodes in order of priority
+    if (locality or !game.isSorted()) {
+        input = &game;
+        order = new int[game.n_nodes];
+        const int w = workers < 0 ? 1 : workers;
+        if (locality) game.locality_order(order, w);
+        else game.sorted_order(order);
+        int *mapping = new int[game.n_nodes];
+        for (int i=0; i<game.n_nodes; i++) mapping[order[i]] = i;
+        this->game = game.permuted_copy(mapping, w);
+        delete[] mapping;
+        if (locality) logger << "parity game reindexed (sorted copy, ordered for locality)" << std::endl;
+        else logger << "parity game reindexed (sorted copy)" << std::endl;
     }
 }
 
+void
+Oink::initOutcount()
+{
+    const int n_nodes = game->n_nodes;
+    const int threads = this->threads(n_nodes);
+    run_threads(threads, [&] (int t) {
+        int from, to;
+        thread_block(n_nodes, t, threads, &from, &to);
+        for (int i=from; i<to; i++) {
+            outcount[i] = std::count_if(game->out(i).begin(), game->out(i).end(),
+                    [&] (const int n) { return disabled[n] == 0; });
+        }
+    });
+}
+
+void
+Oink::setLocality(bool val)
+{
+    if (val == locality) return;
+    locality = val;
+    prepare(input != NULL ? *input : *game);
+}
+
+Oink::Oink(Oink &parent, std::ostream &out) : game(parent.game), logger(out), todo(parent.game->n_nodes), disabled(parent.game->n_nodes)
+{
+    this->parent = &parent;
+    solver = parent.solver;
+    trace = parent.trace;
+    outcount = parent.outcount;
+    disabled.set();
+}
+
 Oink::~Oink()
 {
-    delete[] outcount;
+    if (parent == NULL) delete[] outcount;
+    delete[] local;
+    if (input != NULL) delete game;
+    delete[] order;
 }
 
 /**
- * Find all SCCs at priority p, game limited to nodes with priority <= p 
- * Then for every SCC that contains edges and a node with priority p, can win
- * with priority p and is therefore a counterexample to the strategy.
+ * A set of nodes of player <pl> for solveTrivialCycles: the range [<begin>,<end>) of the node array,
+ * the nodes <i> of which have <set[i]> equal to <id>.
+ */
+struct wcwc_set
+{
+    int begin, end, id, pl;
+};
+
+/**
+ * A winning winner-controlled SCC: the range [<begin>,<end>) of the node array, with highest node <top>.
+ */
+struct wcwc_scc
+{
+    int begin, end, top;
+};
+
+/**
+ * Find all winner-controlled winning cycles, i.e., cycles of nodes owned by one player on which the
+ * highest priority has the parity of that player, with a forward-backward SCC decomposition of the
+ * subgraph of each player. Of a set of nodes, we first trim nodes without a successor or predecessor
+ * in the set. Then we take the node with the highest priority (the pivot), the nodes that are
+ * reachable from it (F) and the nodes that can reach it (B). F&B is the SCC of the pivot, which is
+ * won if the pivot has the parity of the player, and is otherwise decomposed again without the nodes
+ * of the priority of the pivot. F-B, B-F and the remaining nodes are decomposed independently.
+ * The sets are ranges of one node array that are partitioned in-place, and are decomposed in parallel.
+ * Finally, all winning SCCs are solved at once and attracted with a single flush.
  */
 int
 Oink::solveTrivialCycles()
 {
-    // Record number of trivial cycles
-    int count = 0;
-
-    // Allocate and initialize datastructures
     const int n_nodes = game->n_nodes;
-    int *done = new int[n_nodes];
-    int64_t *low = new int64_t[n_nodes];
-    for (int i=0; i<n_nodes; i++) done[i] = disabled[i] ? -2 : -1;
-    for (int i=0; i<n_nodes; i++) low[i] = 0;
-
-    std::vector<int> res;
-    std::vector<int> scc;
-    std::stack<int> st;
-    std::queue<int> q;
-
-    const auto &in = game->in;
-    const auto &out = game->out;
-    const auto &owner = game->owner;
-    const auto &priority = game->priority;
-
-    int64_t pre = 0;
-
-    for (int i=n_nodes-1; i>=0; i--) {
-        if (disabled[i]) continue;
-        if (done[i] == -2) continue; // already know to skip this
-
-        /**
-         * We're going to search all winner-controlled SCCs reachable from node <i>
-         */
-        const int pr = game->priority[i];
-        const int pl = pr & 1;
-
-        /**
-         * Only start at unsolved winner-controlled and not yet seen for this priority
-         */
-        if (owner[i] != pl) {
-            done[i] = -2; // highest priority but not winner-controlled, never check again
-            continue;
-        }
-
-        if (done[i] == pr) continue; // already visited in this search
-
-        /**
-         * Set bot to pre...
-         */
-        int64_t bot = pre;
-
-        /**
-         * Start forward DFS at <i>
-         */
-        st.push(i);
-        while (!st.empty()) {
-            int idx = st.top();
-
-            /**
-             * When we see it for the first time, we assign the next number to it and add it to <res>.
-             */
-            if (low[idx] <= bot) {
-                low[idx] = ++pre;
-                if (pre < 0) LOGIC_ERROR; // overflow on a 64-bit integer...
-                res.push_back(idx);
-            }
-
-            /**
-             * Now we check all outgoing (allowed) edges.
-             * If seen earlier, then update "min"
-             * If new, then 'recurse'
-             */
-            int min = low[idx];
-            bool pushed = false;
-            for (auto to : out[idx]) {
-                /**
-                 * Only go to lower priority nodes, controlled by <pl>, that are not excluded or seen this round.
-                 */
-                if (disabled[i]) continue;
-                if (to > i or done[to] == -2 or done[to] == pr or owner[to] != pl) continue;
-                if (low[to] <= bot) {
-                    // not visited, add to <st> and break!
-                    st.push(to);
-                    pushed = true;
-                    break;
-                } else {
-                    // visited, update min
-                    if (low[to] < min) min = low[to];
-                }
-            }
-            if (pushed) continue; // we pushed...
-
-            /**
-             * If we're here, then there was no new edge and we check if we're the root of an SCC
-             */
-            if (min < low[idx]) {
-                // not the root
-                low[idx] = min;
-                st.pop();
+    int *nodes = new int[n_nodes];      // all nodes, every set is a range of this array
+    int *set = new int[n_nodes];        // id of the set of each node, -1 if none
+    int *outdeg = new int[n_nodes];     // number of successors in the set (for trimming)
+    int *indeg = new int[n_nodes];      // number of predecessors in the set (for trimming)
+    int *str = new int[n_nodes];        // strategy for the nodes of a won SCC
+    char *mark = new char[n_nodes];     // 1 if in F, 2 if in B
+    memset(mark, 0, n_nodes);
+
+    // the initial sets: the unsolved nodes of each player
+    std::vector<wcwc_set> sets;
+    int count = 0;
+    for (int pl=0; pl<2; pl++) {
+        const int begin = count;
+        for (int i=0; i<n_nodes; i++) {
+            if (disabled[i] or game->owner[i] != pl) {
+                if (pl == 0) set[i] = -1;
                 continue;
             }
-
-            /**
-             * We're the root of an scc. Move the scc from <res> to <scc>.
-             * Record highest prio, highest prio of good parity, highest node of good parity.
-             */
-            int max_pr = -1, max_pr_pl = -1, max_pr_n = -1;
-            for (;;) {
-                if (res.empty()) LOGIC_ERROR;
-                int n = res.back();
-                res.pop_back();
-                scc.push_back(n);
-                done[n] = pr; // dont check again this round
-                if (low[n] != min) low[n] = min; // set it [for strategy]
-                int d = priority[n];
-                if (d > max_pr) max_pr = d;
-                if ((d&1) == pl and d > max_pr_pl) {
-                    max_pr_pl = d;
-                    max_pr_n = n;
-                }
-                if (n == idx) break; // end when done
+            nodes[count++] = i;
+            set[i] = pl;
+        }
+        if (count != begin) sets.push_back({begin, count, pl, pl});
+    }
+    int next_id = 2;
+
+    // other threads read <set> (and <mark>) of the nodes in the neighbourhood of their sets
+    const auto set_of = [&] (int v) { return __atomic_load_n(&set[v], __ATOMIC_RELAXED); };
+    const auto set_set = [&] (int v, int id) { __atomic_store_n(&set[v], id, __ATOMIC_RELAXED); };
+    const auto mark_of = [&] (int v) { return __atomic_load_n(&mark[v], __ATOMIC_RELAXED); };
+    const auto mark_set = [&] (int v, char m) { __atomic_store_n(&mark[v], m, __ATOMIC_RELAXED); };
+
+    const auto process = [&] (const wcwc_set &S, std::vector<int> &q, std::vector<wcwc_set> &out, std::vector<wcwc_scc> &won) {
+        const int id = S.id;
+        int *first = nodes + S.begin, *last = nodes + S.end;
+
+        // trim nodes without successor or predecessor in the set (repeatedly)
+        q.clear();
+        for (int *ptr = first; ptr != last; ptr++) {
+            const int v = *ptr;
+            outdeg[v] = indeg[v] = 0;
+            for (int to : game->out(v)) if (set_of(to) == id) outdeg[v]++;
+            for (int from : game->in(v)) if (set_of(from) == id) indeg[v]++;
+        }
+        for (int *ptr = first; ptr != last; ptr++) {
+            const int v = *ptr;
+            if (outdeg[v] == 0 or indeg[v] == 0) { set_set(v, -1); q.push_back(v); }
+        }
+        for (size_t k=0; k<q.size(); k++) {
+            const int v = q[k];
+            for (int to : game->out(v)) {
+                if (set_of(to) == id and --indeg[to] == 0) { set_set(to, -1); q.push_back(to); }
             }
-
-            /**
-             * Check if a single-node SCC without a self-loop
-             */
-            if (scc.size() == 1) {
-                const auto &out_idx = out[idx];
-                if (std::find(out_idx.begin(), out_idx.end(), idx) == out_idx.end()) {
-                    // no self-loop
-                    done[idx] = -2; // never check again
-                    scc.clear();
-                    st.pop();
-                    continue;
-                }
+            for (int from : game->in(v)) {
+                if (set_of(from) == id and --outdeg[from] == 0) { set_set(from, -1); q.push_back(from); }
             }
+        }
+        last = std::partition(first, last, [&] (int v) { return set_of(v) == id; });
+        if (first == last) return;
 
-            /**
-             * Check if the highest priority in the SCC is actually won by <pl>.
-             */
+        // the pivot is the node with the highest priority
+        int pivot = *first;
+        for (int *ptr = first; ptr != last; ptr++) {
+            if (game->priority[*ptr] > game->priority[pivot]) pivot = *ptr;
+        }
 
-            if ((max_pr & 1) != pl) {
-                for (auto n : scc) if (priority[n] > max_pr_pl) done[n] = -2; // never check again
-                scc.clear();
-                st.pop();
-                continue;
-                // Note that this SCC will be found again in lower runs, but without offending nodes.
+        // forward and backward search from the pivot
+        q.clear();
+        q.push_back(pivot);
+        mark_set(pivot, mark_of(pivot) | 1);
+        for (size_t k=0; k<q.size(); k++) {
+            for (int to : game->out(q[k])) {
+                if (set_of(to) == id and (mark_of(to) & 1) == 0) { mark_set(to, mark_of(to) | 1); q.push_back(to); }
             }
-
-            /**
-             * OK, got a winner!
-             */
-
-            if (trace) {
-                logger << "winner-controlled scc with win priority \033[1;34m" << max_pr << "\033[m" << std::endl;
+        }
+        q.clear();
+        q.push_back(pivot);
+        mark_set(pivot, mark_of(pivot) | 2);
+        for (size_t k=0; k<q.size(); k++) {
+            for (int from : game->in(q[k])) {
+                if (set_of(from) == id and (mark_of(from) & 2) == 0) { mark_set(from, mark_of(from) | 2); q.push_back(from); }
             }
+        }
 
-            // Set strategies for all nodes in the SCC via backward search
-            q.push(max_pr_n);
-            while (!q.empty()) {
-                int cur = q.front();
-                q.pop();
-                for (int from : in[cur]) {
-                    if (low[from] != min or disabled[from]) continue;
-                    solve(from, pl, cur); // also sets "disabled"
-                    q.push(from);
+        // partition into F&B, F-B, B-F and the rest
+        int *scc_end = std::partition(first, last, [&] (int v) { return mark_of(v) == 3; });
+        int *f_end = std::partition(scc_end, last, [&] (int v) { return mark_of(v) == 1; });
+        int *b_end = std::partition(f_end, last, [&] (int v) { return mark_of(v) == 2; });
+
+        const auto out_pivot = game->out(pivot);
+        if (scc_end - first == 1 and std::find(out_pivot.begin(), out_pivot.end(), pivot) == out_pivot.end()) {
+            // the SCC of the pivot is a single node without a self-loop
+            set_set(pivot, -1);
+        } else if ((game->priority[pivot]&1) == S.pl) {
+            // won: compute the strategy with a backward search from the pivot in the SCC
+            for (int *ptr = first; ptr != scc_end; ptr++) str[*ptr] = -1;
+            q.clear();
+            q.push_back(pivot);
+            for (size_t k=0; k<q.size(); k++) {
+                const int cur = q[k];
+                for (int from : game->in(cur)) {
+                    if (set_of(from) != id or mark_of(from) != 3 or str[from] != -1) continue;
+                    str[from] = cur;
+                    q.push_back(from);
                 }
             }
-            flush(); // this triggers attraction of every winner-controlled node in the stack...
+            for (int *ptr = first; ptr != scc_end; ptr++) set_set(*ptr, -1);
+            won.push_back({(int)(first - nodes), (int)(scc_end - nodes), pivot});
+        } else {
+            // not won: decompose the SCC again without the nodes of the priority of the pivot
+            const int pr = game->priority[pivot];
+            int *rest = std::partition(first, scc_end, [&] (int v) { return game->priority[v] != pr; });
+            for (int *ptr = rest; ptr != scc_end; ptr++) set_set(*ptr, -1);
+            if (first != rest) out.push_back({(int)(first - nodes), (int)(rest - nodes), 0, S.pl});
+        }
+        if (scc_end != f_end) out.push_back({(int)(scc_end - nodes), (int)(f_end - nodes), 0, S.pl});
+        if (f_end != b_end) out.push_back({(int)(f_end - nodes), (int)(b_end - nodes), 0, S.pl});
+        if (b_end != last) out.push_back({(int)(b_end - nodes), (int)(last - nodes), 0, S.pl});
+
+        // give the new sets their ids
+        for (auto &T : out) {
+            T.id = __sync_fetch_and_add(&next_id, 1);
+            for (int k=T.begin; k<T.end; k++) set_set(nodes[k], T.id);
+        }
+        for (int k=S.begin; k<S.end; k++) mark_set(nodes[k], 0);
+    };
+
+    // decompose the sets in parallel, every thread takes the next set until all are done
+    const int threads = this->threads(count);
+    std::vector<std::vector<wcwc_scc>> won(threads);
+    std::mutex mutex;
+    std::condition_variable cond;
+    int busy = 0;
+
+    run_threads(threads, [&] (int t) {
+        std::vector<int> q;
+        std::vector<wcwc_set> out;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cond.wait(lock, [&] { return !sets.empty() or busy == 0; });
+            if (sets.empty()) break;
+            const wcwc_set S = sets.back();
+            sets.pop_back();
+            busy++;
+            lock.unlock();
+
+            out.clear();
+            process(S, q, out, won[t]);
+
+            lock.lock();
+            sets.insert(sets.end(), out.begin(), out.end());
+            busy--;
+            cond.notify_all();
+        }
+    });
+
+    // solve all won SCCs (in a fixed order), then attract to them
+    std::vector<wcwc_scc> sccs;
+    for (auto &w : won) sccs.insert(sccs.end(), w.begin(), w.end());
+    std::sort(sccs.begin(), sccs.end(), [] (const wcwc_scc &a, const wcwc_scc &b) { return a.top > b.top; });
 
-            /**
-             * For obvious reasons, all nodes on the stack are now solved.
-             */
-            while (!st.empty()) st.pop();
-            res.clear();
-            scc.clear();
-            count++;
+    for (auto &scc : sccs) {
+        const int pl = game->owner[scc.top];
+        if (trace) {
+            logger << "winner-controlled scc with win priority \033[1;34m" << game->priority[scc.top] << "\033[m" << std::endl;
         }
+        for (int k=scc.begin; k<scc.end; k++) solve(nodes[k], pl, str[nodes[k]]);
     }
+    flush();
 
-    delete[] done;
-    delete[] low;
-    return count;
+    delete[] nodes;
+    delete[] set;
+    delete[] outdeg;
+    delete[] indeg;
+    delete[] str;
+    delete[] mark;
+    return sccs.size();
 }
 
 int
 Oink::solveSelfloops()
 {
-    int res = 0;
-    for (int n=0; n<game->n_nodes; n++) {
-        if (disabled[n]) continue;
-
-        auto &out = game->out[n];
-        for (auto it = out.begin(); it != out.end(); it++) {
-            if (n != *it) continue;
+    // find the nodes with a self-loop in parallel (each thread in a block of nodes)...
+    const int threads = this->threads(game->n_nodes);
+    std::vector<std::vector<int>> loops(threads);
+    run_threads(threads, [&] (int t) {
+        int from, to;
+        thread_block(game->n_nodes, t, threads, &from, &to);
+        for (int n=from; n<to; n++) {
+            if (disabled[n]) continue;
+            for (int succ : game->out(n)) {
+                if (n == succ) {
+                    loops[t].push_back(n);
+                    break;
+                }
+            }
+        }
+    });
 
-            // found a self-loop
+    // ...then resolve them in order of the nodes
+    int res = 0;
+    for (auto &nodes : loops) {
+        for (int n : nodes) {
             if (game->owner[n] == (game->priority[n]&1)) {
                 // self-loop is winning
                 if (trace) logger << "winning self-loop with priority \033[1;34m" << game->priority[n] << "\033[m" << std::endl;
                 solve(n, game->owner[n], n);
             } else {
                 // self-loop is losing
-                if (out.size() == 1) {
+                if (game->out(n).size() == 1) {
                     // it is a losing dominion
                     solve(n, 1 - game->owner[n], -1);
                 } else {
-                    // remove the edge
-                    out.erase(it);
-                    auto &in = game->in[n];
-                    in.erase(std::remove(in.begin(), in.end(), n), in.end());
+                    // remove the edge (in-place in the edge arrays)
+                    game->removeEdge(n, n);
                     outcount[n]--;
                 }
             }
 
             res++;
-            break;
         }
     }
 
@@ -274,25 +379,28 @@ Oink::solveSelfloops()
 bool
 Oink::solveSingleParity()
 {
-    int parity = -1;
-    for (int i=0; i<game->n_nodes; i++) {
-        if (disabled[i]) continue;
-        if (parity == -1) {
-            parity = game->priority[i]&1;
-        } else if (parity == (game->priority[i]&1)) {
-            continue;
-        } else {
-            return false;
+    // find which parities occur (bit 0 for even, bit 1 for odd), each thread in a block of nodes
+    const int threads = this->threads(game->n_nodes);
+    int parities = 0;
+    run_threads(threads, [&] (int t) {
+        int from, to;
+        thread_block(game->n_nodes, t, threads, &from, &to);
+        int found = 0;
+        for (int i=from; i<to and found != 3; i++) {
+            if (!disabled[i]) found |= 1 << (game->priority[i]&1);
         }
-    }
-    if (parity == 0 or parity == 1) {
+        __sync_fetch_and_or(&parities, found);
+    });
+
+    if (parities == 1 or parities == 2) {
+        const int parity = parities >> 1;
         // solved with random strategy
         logger << "parity game only has parity " << (parity ? "odd" : "even") << std::endl;
         for (int i=0; i<game->n_nodes; i++) {
             if (disabled[i]) continue;
             if (game->owner[i] == parity) {
                 // set random strategy for winner
-                for (int to : game->out[i]) {
+                for (int to : game->out(i)) {
                     if (disabled[to]) continue;
                     solve(i, parity, to);
                     break;
@@ -304,7 +412,7 @@ Oink::solveSingleParity()
         flush();
         return true;
     } else {
-        // all disabled
+        // both parities, or all disabled
         return false;
     }
 }
@@ -312,6 +420,8 @@ Oink::solveSingleParity()
 void
 Oink::solve(int node, int win, int strategy)
 {
+    auto guard = lockGame();
+
     if (game->solved[node] or disabled[node]) LOGIC_ERROR;
 
     game->solved[node] = true;
@@ -330,9 +440,110 @@ Oink::solve(int node, int win, int strategy)
     // */
 }
 
+/**
+ * The state of a parallel flush, for flush_par and flush_list.
+ */
+struct flush_state
+{
+    Game *game;
+    int *outcount;
+    std::vector<int> *found; // per worker, the attracted nodes won by even (2*W) and odd (2*W+1)
+};
+
+VOID_TASK_3(flush_par, int, v, int, winner, flush_state*, f)
+{
+    Game *g = f->game;
+    std::vector<int> &ours = f->found[2*LACE_WORKER_ID+winner];
+    int c = 0;
+
+    // base on ORIGINAL game in!
+    for (int in : g->in(v)) {
+        if (g->solved[in]) continue; // solved before this flush
+        volatile int *ptr = &f->outcount[in];
+        bool attracted = false;
+        if (g->owner[in] == winner) {
+            // node of winner, use CAS to claim it
+            for (int cnt = *ptr; cnt >= 0; cnt = *ptr) {
+                if (__sync_bool_compare_and_swap(ptr, cnt, -1)) {
+                    g->strategy[in] = v;
+                    attracted = true;
+                    break;
+                }
+            }
+        } else {
+            // node of loser, decrement (in a CAS loop); the last one claims it
+            for (int cnt = *ptr; cnt > 0; cnt = *ptr) {
+                const int next = cnt == 1 ? -1 : cnt-1;
+                if (__sync_bool_compare_and_swap(ptr, cnt, next)) {
+                    attracted = next == -1;
+                    break;
+                }
+            }
+        }
+        if (attracted) {
+            ours.push_back(in);
+            SPAWN(flush_par, in, winner, f);
+            c++;
+        }
+    }
+
+    while (c) { SYNC(flush_par); c--; }
+}
+
+VOID_TASK_3(flush_list, const int*, nodes, int, count, flush_state*, f)
+{
+    if (count > 1) {
+        SPAWN(flush_list, nodes, count/2, f);
+        CALL(flush_list, nodes+count/2, count-count/2, f);
+        SYNC(flush_list);
+    } else if (count == 1) {
+        CALL(flush_par, nodes[0], f->game->winner[nodes[0]], f);
+    }
+}
+
+void
+Oink::flushPar()
+{
+    // take the todo buffer, mark it done
+    std::vector<int> nodes;
+    while (todo.nonempty()) {
+        int v = todo.pop();
+        if (outcount[v] == -1) continue;
+        outcount[v] = -1;
+        nodes.push_back(v);
+    }
+
+    // the attractor only claims nodes (in outcount and strategy), the bitsets are updated afterwards
+    const int W = lace_workers();
+    std::vector<std::vector<int>> found(2*W);
+    flush_state f;
+    f.game = game;
+    f.outcount = outcount;
+    f.found = found.data();
+
+    LACE_ME;
+    CALL(flush_list, nodes.data(), (int)nodes.size(), &f);
+
+    for (int i=0; i<2*W; i++) {
+        for (int v : found[i]) {
+            game->solved[v] = true;
+            game->winner[v] = i & 1;
+            disabled[v] = true;
+        }
+    }
+}
+
 void
 Oink::flush()
 {
+    // in a Lace worker, attract in parallel (but a child attracts sequentially under the lock)
+    if (parent == NULL and workers >= 0 and lace_workers() > 1 and lace_get_worker() != NULL) {
+        flushPar();
+        return;
+    }
+
+    auto guard = lockGame();
+
     // flush the todo buffer
     while (todo.nonempty()) {
         int v = todo.pop();
@@ -347,7 +558,7 @@ Oink::flush()
         bool winner = game->winner[v];
 
         // base on ORIGINAL game in!
-        for (int in : game->in[v]) {
+        for (int in : game->in(v)) {
             if (game->solved[in]) continue; // already done
             if (game->owner[in] == winner) {
                 // node of winner
@@ -381,11 +592,245 @@ Oink::setSolver(std::string label)
     solver = Solvers().id(label);
 }
 
+/**
+ * The arrays of a game and their new copies, for place_arrays.
+ */
+struct placed_arrays
+{
+    const Game *game;
+    int *priority;
+    edge_offset *outa;
+    edge_offset *ina;
+    int *outs;
+    int *ins;
+};
+
+VOID_TASK_1(place_arrays, placed_arrays*, a)
+{
+    // every worker copies (and thus first-touches) the arrays of its own block of nodes
+    const Game *g = a->game;
+    int from, to;
+    thread_block(g->n_nodes, LACE_WORKER_ID, lace_workers(), &from, &to);
+    const int last = to == g->n_nodes ? to+1 : to; // (including the end of the last list)
+
+    memcpy(a->priority + from, g->priority + from, sizeof(int[to-from]));
+    memcpy(a->outa + from, g->outa + from, sizeof(edge_offset[last-from]));
+    memcpy(a->ina + from, g->ina + from, sizeof(edge_offset[last-from]));
+    memcpy(a->outs + g->outa[from], g->outs + g->outa[from], sizeof(int[g->outa[to]-g->outa[from]]));
+    memcpy(a->ins + g->ina[from], g->ins + g->ina[from], sizeof(int[g->ina[to]-g->ina[from]]));
+}
+
+void
+Oink::placeArrays()
+{
+    if (!numa) return;
+
+    const int n = game->n_nodes;
+    placed_arrays a;
+    a.game = game;
+    a.priority = alloc_array<int>(n);
+    a.outa = alloc_array<edge_offset>(n+1);
+    a.ina = alloc_array<edge_offset>(n+1);
+    a.outs = alloc_array<int>(game->outa[n]);
+    a.ins = alloc_array<int>(game->ina[n]);
+
+    LACE_ME;
+    TOGETHER(place_arrays, &a);
+
+    game->replace_arrays(a.priority, a.outa, a.ina, a.outs, a.ins);
+    logger << "placed the game over " << lace_workers() << " workers" << std::endl;
+}
+
 VOID_TASK_1(solve_loop, Oink*, s)
 {
+    s->placeArrays();
     s->solveLoop();
 }
 
+void
+Oink::solveSCC(const int *scc, int size)
+{
+    Solvers solvers;
+
+    std::vector<int> sel;
+    {
+        auto guard = lockGame();
+        for (int i=0; i<size; i++) {
+            if (!game->solved[scc[i]]) sel.push_back(scc[i]);
+        }
+    }
+    if (sel.empty()) return;
+
+    logger << "solving bottom SCC of " << sel.size() << " nodes" << std::endl;
+
+    // unless the SCC is most of the game, only give the solver the SCC
+    if (2*sel.size() < (size_t)game->n_nodes) {
+        solveLocal(sel);
+        return;
+    }
+
+    for (int v : sel) disabled[v] = false;
+
+    Solver *s = NULL;
+    while (!sel.empty()) {
+        // solve current subgame (again, with the same solver if it supports that)
+        if (s == NULL or !s->resolve()) {
+            delete s;
+            s = solvers.construct(solver, this, game);
+            s->run();
+        }
+
+        // flush the todo buffer
+        flush();
+
+        // the solver may leave a part of the SCC unsolved
+        auto guard = lockGame();
+        sel.erase(std::remove_if(sel.begin(), sel.end(),
+            [&] (const int v) { return game->solved[v]; }), sel.end());
+    }
+    delete s;
+}
+
+void
+Oink::solveLocal(std::vector<int> &sel)
+{
+    if (local == NULL) {
+        local = new int[game->n_nodes];
+        std::fill(local, local + game->n_nodes, -1);
+    }
+
+    // solve the subgame completely, with its own Oink (which does not preprocess)
+    std::sort(sel.begin(), sel.end());
+    Game *sub = game->local_subgame(sel.data(), sel.size(), local);
+    {
+        Oink oink(*sub, logger);
+        oink.solver = solver;
+        oink.trace = trace;
+        oink.workers = workers; // (-1 in a child, which must not run Lace tasks)
+        oink.initOutcount();
+        oink.solveGame();
+    }
+
+    // copy the solution to the nodes of the game (enabled for solve), then attract
+    for (int v : sel) disabled[v] = false;
+    for (unsigned i=0; i<sel.size(); i++) {
+        const int str = sub->strategy[i];
+        solve(sel[i], sub->winner[i], str == -1 ? -1 : sel[str]);
+    }
+    delete sub;
+    flush();
+}
+
+/**
+ * The SCC DAG for solve_scc.
+ */
+struct scc_schedule
+{
+    Oink *oink;
+    const int *nodes;          // the SCCs (see Oink::getSCCs)
+    const int *index;
+    const int *scc;            // the SCC of each node (-1 if solved before the decomposition)
+    int *pending;              // for each SCC, the number of edges to unsolved other SCCs
+    std::vector<Oink*> child;  // for each worker, the child that solves SCCs
+    std::vector<std::ostream*> quiet; // for each child, its own stream without buffer (not shared,
+                                      // as every write to it sets its badbit)
+};
+
+VOID_TASK_2(solve_scc, int, c, scc_schedule*, s)
+{
+    const Game *game = s->oink->game;
+    int spawned = 0;
+
+    while (c != -1) {
+        const int *scc = s->nodes + s->index[c];
+        const int size = s->index[c+1] - s->index[c];
+        s->child[LACE_WORKER_ID]->solveSCC(scc, size);
+
+        // release the predecessors; spawn all that are now ready, except one that we solve next
+        int next = -1;
+        for (int i=0; i<size; i++) {
+            for (int from : game->in(scc[i])) {
+                const int d = s->scc[from];
+                if (d == -1 or d == c) continue;
+                if (__sync_sub_and_fetch(&s->pending[d], 1) != 0) continue;
+                if (next != -1) {
+                    SPAWN(solve_scc, next, s);
+                    spawned++;
+                }
+                next = d;
+            }
+        }
+        c = next;
+    }
+
+    while (spawned) { SYNC(solve_scc); spawned--; }
+}
+
+void
+Oink::solveSCCs()
+{
+    Solvers solvers;
+
+    // decompose the unsolved subgame once
+    disabled = game->solved;
+    std::vector<int> nodes, index;
+    getSCCs(nodes, index);
+    const int count = index.size() - 1;
+    logger << "found " << count << " SCCs" << std::endl;
+
+    // only the unsolved nodes of the current SCC are enabled
+    disabled.set();
+
+    if (lace_workers() > 1 and lace_get_worker() != NULL and !solvers.isParallel(solver)) {
+        // count the edges from each SCC to other SCCs
+        std::vector<int> scc(game->n_nodes, -1);
+        for (int c=0; c<count; c++) {
+            for (int i=index[c]; i<index[c+1]; i++) scc[nodes[i]] = c;
+        }
+        std::vector<int> pending(count, 0);
+        for (int c=0; c<count; c++) {
+            for (int i=index[c]; i<index[c+1]; i++) {
+                for (int to : game->out(nodes[i])) {
+                    if (scc[to] != -1 and scc[to] != c) pending[c]++;
+                }
+            }
+        }
+
+        // every worker solves SCCs with its own child (which does not log)
+        const int W = lace_workers();
+        scc_schedule s;
+        s.oink = this;
+        s.nodes = nodes.data();
+        s.index = index.data();
+        s.scc = scc.data();
+        s.pending = pending.data();
+        for (int w=0; w<W; w++) {
+            s.quiet.push_back(new std::ostream(NULL));
+            s.child.push_back(new Oink(*this, *s.quiet.back()));
+        }
+
+        // start with the bottom SCCs, solve_scc spawns the others when they are ready
+        LACE_ME;
+        int spawned = 0;
+        for (int c=0; c<count; c++) {
+            if (pending[c] != 0) continue;
+            SPAWN(solve_scc, c, &s);
+            spawned++;
+        }
+        while (spawned) { SYNC(solve_scc); spawned--; }
+
+        for (Oink *child : s.child) delete child;
+        for (std::ostream *out : s.quiet) delete out;
+        disabled = game->solved;
+        logger << "solved " << count << " SCCs on " << W << " workers" << std::endl;
+        return;
+    }
+
+    // solve bottom-up; the successors of each SCC are then solved, and the solved nodes
+    // are attracted into its predecessors by flush, which also disables them
+    for (int c=0; c<count; c++) solveSCC(nodes.data() + index[c], index[c+1] - index[c]);
+}
+
 void
 Oink::solveLoop()
 {
@@ -395,40 +840,69 @@ Oink::solveLoop()
     Solvers solvers;
     logger << "solving using " << solvers.desc(solver) << std::endl;
 
-    while (!game->gameSolved()) {
-        // disabled all solved vertices
-        disabled = game->solved;
+    if (bottomSCC) solveSCCs();
+    else solveGame();
+}
+
+void
+Oink::solveGame()
+{
+    Solvers solvers;
+    Solver *s = NULL;
 
-        if (bottomSCC) {
-            // solve bottom SCC
+    for (int left = game->countUnsolved(); left != 0; left = game->countUnsolved()) {
+        // once most of the game is solved, the solver would mostly skip solved nodes and edges
+        if (2*left < game->n_nodes) {
+            delete s;
             std::vector<int> sel;
-            getBottomSCC(sel);
-            assert(sel.size() != 0);
-            disabled.set();
-            for (int i : sel) disabled[i] = false;
-            logger << "solving bottom SCC of " << sel.size() << " nodes (";
-            logger << game->countUnsolved() << " nodes left)" << std::endl;
+            for (int i=0; i<game->n_nodes; i++) {
+                if (!game->solved[i]) sel.push_back(i);
+            }
+            logger << "continuing on a compact copy of the " << left << " unsolved nodes" << std::endl;
+            solveLocal(sel);
+            return;
         }
 
-        // solve current subgame
-        Solver *s = solvers.construct(solver, this, game);
-        s->run();
-        delete s;
+        // disabled all solved vertices
+        disabled = game->solved;
+
+        // solve current subgame (again, with the same solver if it supports that)
+        if (s == NULL or !s->resolve()) {
+            delete s;
+            s = solvers.construct(solver, this, game);
+            s->run();
+        }
 
         // flush the todo buffer
         flush();
 
         // report number of nodes left
-        if (!bottomSCC) {
-            logger << game->countUnsolved() << " nodes left." << std::endl;
-        }
+        logger << game->countUnsolved() << " nodes left." << std::endl;
     }
+    delete s;
 }
 
 void
 Oink::run()
 {
-    // NOTE: we assume that the game is already reindexed...
+    runSorted();
+
+    // write the solution back to the original (unsorted) game
+    if (input != NULL) {
+        for (int i=0; i<game->n_nodes; i++) {
+            const int k = order[i];
+            input->solved[k] = game->solved[i];
+            input->winner[k] = game->winner[i];
+            input->strategy[k] = game->strategy[i] == -1 ? -1 : order[game->strategy[i]];
+        }
+    }
+}
+
+void
+Oink::runSorted()
+{
+    // initialize outcount (for flush/attract), now that the number of workers is known
+    initOutcount();
 
     /**
      * Now inflate / compress / renumber...
@@ -480,37 +954,18 @@ Oink::run()
     }
 
     /***
-     * Build arrays
+     * Start Lace if we are parallel (or to solve independent SCCs concurrently)
      */
-    {
-        // count number of edges
-        size_t len = game->edgecount() + game->n_nodes;
-
-        outa = new int[game->n_nodes];
-        ina = new int[game->n_nodes];
-        outs = new int[len];
-        ins = new int[len];
-
-        int outi = 0;
-        int ini = 0;
 
-        for (int i=0; i<game->n_nodes; i++) {
-            outa[i] = outi;
-            ina[i] = ini;
-            for (int to : game->out[i]) outs[outi++] = to;
-            for (int fr : game->in[i]) ins[ini++] = fr;
-            outs[outi++] = -1;
-            ins[ini++] = -1;
-        }
+    if (numa and (workers < 0 or lace_workers() != 0 or !(Solvers().isParallel(solver) or bottomSCC))) {
+        // the game is only placed over the workers if we start Lace ourselves
+        logger << "\033[1;7mWARNING\033[m: ignoring --numa, Oink does not start Lace for this run!" << std::endl;
     }
 
-    /***
-     * Start Lace if we are parallel
-     */
-
-    if (Solvers().isParallel(solver)) {
+    if (Solvers().isParallel(solver) or (bottomSCC and workers >= 0)) {
         if (workers >= 0) {
             if (lace_workers() == 0) {
+                if (numa) lace_set_pinning(1);
                 lace_init(workers, 100*1000*1000);
                 logger << "initialized Lace with " << lace_workers() << " workers" << std::endl;
                 lace_startup(0, (lace_startup_cb)TASK(solve_loop), this);
@@ -525,11 +980,6 @@ Oink::run()
     } else {
         solveLoop();
     }
-
-    delete[] outa;
-    delete[] ina;
-    delete[] outs;
-    delete[] ins;
 }
 
 }
@@ -18,6 +18,7 @@
 #define OINK_HPP
 
 #include <iostream>
+#include <mutex>
 #include <vector>
 
 #define _INLINE_ __attribute__((always_inline))
@@ -25,9 +26,13 @@
 #include "game.hpp"
 #include "uintqueue.hpp"
 
+struct _WorkerP;
+struct _Task;
+
 namespace pg {
 
 class Solver;
+struct scc_schedule;
 
 class Oink
 {
@@ -37,6 +42,10 @@ public:
 
     /**
      * After configuring Oink, use run() to run the solver.
+     * The game does not need to be reindexed: if the nodes are not in order of priority (or with
+     * locality), Oink solves a sorted copy and writes the solution back, leaving the game in its order.
+     * Otherwise Oink solves the given game itself, so preprocessing that changes the game (inflate,
+     * compress, renumber and the removal of self-loops) modifies the caller's game in place.
      */
     void run();
 
@@ -81,6 +90,20 @@ public:
      */
     void setBottomSCC(bool val) { bottomSCC = val; }
 
+    /**
+     * Instruct Oink whether to order the nodes of each priority for locality. (Default false)
+     * Oink then solves a copy of the game where connected nodes of the same priority are
+     * numbered in breadth-first order (see Game::locality_order).
+     */
+    void setLocality(bool val);
+
+    /**
+     * Instruct Oink whether to run parallel solvers in NUMA-aware mode. (Default false)
+     * The Lace workers are then pinned to the processors in order, and the priorities and edge arrays
+     * of the game are copied in parallel, such that every worker first-touches the block of its nodes.
+     */
+    void setNuma(bool val) { numa = val; }
+
     /**
      * Set the number of workers for parallel solvers (psi and zielonka).
      * -1 for sequential code, 0 for autodetect.
@@ -105,7 +128,18 @@ public:
 
     void solveLoop(void);
 
+    /**
+     * In NUMA-aware mode, copy the priorities and edge arrays of the game in blocks of nodes,
+     * one block per Lace worker. (Must be called from a Lace worker.)
+     */
+    void placeArrays(void);
+
 protected:
+    /**
+     * The parallel version of flush, using the Lace workers. (Must be called from a Lace worker.)
+     */
+    void flushPar(void);
+
     /**
      * Solve winner-controlled winning cycles.
      * Returns number of cycles solved.
@@ -138,12 +172,81 @@ protected:
      */
     void getBottomSCC(int start, std::vector<int> &scc, bool nonempty=false);
 
+    /**
+     * Compute all SCCs of the subgame of nodes that are not disabled, in linear time.
+     * SCC <i> consists of the nodes <nodes>[<index>[i]] ... <nodes>[<index>[i+1]-1].
+     * Every SCC comes after all SCCs that it reaches, i.e., bottom SCCs come first.
+     */
+    void getSCCs(std::vector<int> &nodes, std::vector<int> &index);
+
+    /**
+     * Solve the game SCC by SCC, bottom-up in the SCC DAG, which is computed once.
+     * With a sequential solver on more than one Lace worker, every SCC of which all successors are
+     * solved is solved concurrently with the other such SCCs, by a child Oink on each worker.
+     */
+    void solveSCCs(void);
+
+    /**
+     * Solve the unsolved nodes of the SCC <scc> of <size> nodes; the other nodes must be disabled.
+     * All SCCs reachable from it must be solved.
+     */
+    void solveSCC(const int *scc, int size);
+
+    /**
+     * Run the solver until the game is solved. Once less than half of the nodes is unsolved,
+     * continue on a compact copy of the unsolved nodes (with solveLocal).
+     */
+    void solveGame(void);
+
+    /**
+     * Solve the unsolved nodes <sel> on a copy with local indices (see Game::local_subgame), so
+     * the solver only allocates and scans these nodes. Every node in <sel> must have a successor in
+     * <sel>; its other successors must be won by the opponent of its owner (as after flush).
+     */
+    void solveLocal(std::vector<int> &sel);
+
+    /**
+     * Create a child of <parent>, which shares its game and outcount, to solve SCCs concurrently.
+     * Its own nodes are all disabled; solve and flush update the shared game under the lock of <parent>.
+     */
+    Oink(Oink &parent, std::ostream &out);
+
+    /**
+     * Lock the game of the parent, if this is a child. (Otherwise returns an empty lock.)
+     */
+    std::unique_lock<std::mutex> lockGame(void) {
+        return parent == NULL ? std::unique_lock<std::mutex>() : std::unique_lock<std::mutex>(parent->mutex);
+    }
+
     /**
      * Tarjan's SCC algorithm, modified to only compute the bottom SCC and avoid disabled nodes.
      */
     void tarjan(int start_node, std::vector<int> &res, bool nonempty);
 
-    Game *game;              // game being solved
+    /**
+     * Number of threads for preprocessing <count> items; 1 unless <workers> is set (see setWorkers).
+     */
+    int threads(size_t count);
+
+    /**
+     * Initialize <outcount> to the number of enabled successors of every node.
+     */
+    void initOutcount(void);
+
+    /**
+     * Set <game> to the given game (with <input> NULL) if it is sorted, or otherwise to a sorted copy;
+     * with <locality>, always to a copy ordered by locality_order.
+     */
+    void prepare(Game &game);
+
+    /**
+     * Run preprocessing and the solver on <game>, which is sorted by priority.
+     */
+    void runSorted(void);
+
+    Game *game;              // game being solved (sorted by priority)
+    Game *input = NULL;      // the game given to Oink, if it is not sorted (then <game> is a sorted copy)
+    int *order = NULL;       // if <input> is set: node <i> of <game> is node <order[i]> of <input>
     std::ostream &logger;    // logger for trace/debug messages
     int solver = -1;         // which solver to use
     int workers = -1;        // number of workers, 0 = autodetect, -1 = use non parallel
@@ -155,16 +258,19 @@ protected:
     bool removeWCWC = true;  // solve winner-controlled winning cycles before solving
     bool solveSingle = true; // solve games with only 1 parity
     bool bottomSCC = false;  // solve per bottom SCC
+    bool locality = false;   // order the nodes of each priority for locality
+    bool numa = false;       // pin the Lace workers and place the game arrays over their memory
 
     uintqueue todo;          // internal queue for solved nodes for flushing
     int *outcount;           // number of unsolved outgoing edges per node (for fast attraction)
-    int *outa;               // index array for outgoing edges
-    int *ina;                // index array for incoming edges
-    int *outs;               // all outgoing edges
-    int *ins;                // all incoming edges
     bitset disabled;         // which vertices are disabled
+    int *local = NULL;       // for solveLocal, all -1 (allocated when first used)
+
+    Oink *parent = NULL;     // for a child that solves SCCs concurrently, the Oink that owns the game
+    std::mutex mutex;        // protects the game and outcount while children solve SCCs
 
     friend class pg::Solver; // to allow access to edges
+    friend void solve_scc_WORK(_WorkerP*, _Task*, int, scc_schedule*);
 };
 
 }
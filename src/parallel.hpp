@@ -0,0 +1,107 @@
+/*
+ * Copyright 2017-2018 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <vector>
+
+/**
+ * Helpers for the (std::thread based) parallel operations on a Game, outside of the solvers.
+ */
+
+namespace pg {
+
+/**
+ * Run <fun>(0) ... <fun>(count-1) on <count> threads (inline if <count> is 1).
+ */
+inline void
+run_threads(int count, const std::function<void(int)> &fun)
+{
+    if (count == 1) {
+        fun(0);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (int t=0; t<count; t++) threads.push_back(std::thread(fun, t));
+    for (auto &thread : threads) thread.join();
+}
+
+/**
+ * Number of threads for <count> items with at least <grain> items per thread.
+ * Uses at most <workers> threads (or all cores if <workers> is 0).
+ */
+inline int
+thread_count(int workers, size_t count, size_t grain)
+{
+    if (workers <= 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    return (int)std::min((size_t)workers, count / grain + 1);
+}
+
+/**
+ * Get the part [<from>,<to>) of thread <t> of <count> items divided over <threads> threads.
+ */
+inline void
+thread_block(size_t count, int t, int threads, int *from, int *to)
+{
+    *from = (int)((count * t) / threads);
+    *to = (int)((count * (t+1)) / threads);
+}
+
+/**
+ * Compute the start index of each node in a -1 terminated CSR array from the degrees in <index>.
+ * Afterwards <index> has <count>+1 entries, the last entry being the total length.
+ * Throws if the total length does not fit in the offset type <T>.
+ */
+template <typename T>
+inline void
+prefix_sum(T *index, int count, int threads)
+{
+    std::vector<int64_t> sums(threads+1, 0);
+
+    run_threads(threads, [&] (int t) {
+        int from, to;
+        thread_block(count, t, threads, &from, &to);
+        int64_t sum = 0;
+        for (int i=from; i<to; i++) sum += index[i] + 1;
+        sums[t+1] = sum;
+    });
+
+    for (int t=0; t<threads; t++) sums[t+1] += sums[t];
+    if (sums[threads] > std::numeric_limits<T>::max()) throw "too many edges";
+
+    run_threads(threads, [&] (int t) {
+        int from, to;
+        thread_block(count, t, threads, &from, &to);
+        T sum = sums[t];
+        for (int i=from; i<to; i++) {
+            const T deg = index[i];
+            index[i] = sum;
+            sum += deg + 1;
+        }
+    });
+
+    index[count] = sums[threads];
+}
+
+}
+
+#endif
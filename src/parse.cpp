@@ -0,0 +1,524 @@
+/*
+ * Copyright 2017-2018 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "game.hpp"
+#include "parallel.hpp"
+
+namespace pg {
+
+static inline bool
+is_whitespace(char ch)
+{
+    return ch == ' ' or ch == '\n' or ch == '\t' or ch == '\r' or ch == '\v' or ch == '\f';
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#define PG_SIMD 1
+
+/**
+ * Classify a block of SCAN bytes at once; bit <i> of the result is set iff byte <i> matches.
+ * (Unsigned trick: <ch> is in [lo,lo+k] iff min(ch-lo,k) == ch-lo.)
+ */
+#if defined(__AVX2__)
+static const int SCAN = 32;
+static const uint32_t SCAN_MASK = 0xffffffff;
+
+static inline uint32_t
+scan_range(const char *p, char lo, char k)
+{
+    __m256i v = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i*)p), _mm256_set1_epi8(lo));
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(k)), v));
+}
+
+static inline uint32_t
+scan_whitespace(const char *p)
+{
+    __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    __m256i sp = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+    __m256i c = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+    __m256i ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(c, _mm256_set1_epi8(4)), c); // \t \n \v \f \r
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(sp, ctl));
+}
+#else
+static const int SCAN = 16;
+static const uint32_t SCAN_MASK = 0xffff;
+
+static inline uint32_t
+scan_range(const char *p, char lo, char k)
+{
+    __m128i v = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)p), _mm_set1_epi8(lo));
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(k)), v));
+}
+
+static inline uint32_t
+scan_whitespace(const char *p)
+{
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i sp = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    __m128i c = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(c, _mm_set1_epi8(4)), c); // \t \n \v \f \r
+    return (uint32_t)_mm_movemask_epi8(_mm_or_si128(sp, ctl));
+}
+#endif
+
+/**
+ * Convert the <len> (1..8) digits at <p> to a number, with 8 readable bytes at <p>.
+ * All digits are combined in parallel in one 64-bit word (little endian).
+ */
+static inline uint64_t
+convert_digits8(const char *p, int len)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    v -= 0x3030303030303030ULL;  // borrows only propagate into the bytes after the digits
+    v <<= 8*(8-len);             // drop the bytes after the digits, prepend zeroes
+    v = (v * 10 + (v >> 8)) & 0x00ff00ff00ff00ffULL;
+    v = (v * 100 + (v >> 16)) & 0x0000ffff0000ffffULL;
+    v = (v * 10000 + (v >> 32)) & 0x00000000ffffffffULL;
+    return v;
+}
+#endif
+
+/**
+ * A part of the input buffer, parsed by one thread.
+ */
+struct pgchunk
+{
+    const char *ptr;        // current position
+    const char *end;        // end of the chunk
+    const char *error;      // first parse error (or NULL)
+    std::vector<int> nodes; // ids of the parsed nodes, in order
+    std::vector<int> degs;  // number of successors of each parsed node
+    std::vector<int> succs; // successors of all parsed nodes
+    std::string labels;     // labels of the parsed nodes, concatenated
+    std::vector<std::pair<int, size_t>> label_ends; // node and end of its label in <labels>
+
+    inline void skip_whitespace()
+    {
+        if (ptr != end and !is_whitespace(*ptr)) return;
+#ifdef PG_SIMD
+        while (end - ptr >= SCAN) {
+            uint32_t m = ~scan_whitespace(ptr) & SCAN_MASK;
+            if (m != 0) { ptr += __builtin_ctz(m); return; }
+            ptr += SCAN;
+        }
+#endif
+        while (ptr != end and is_whitespace(*ptr)) ptr++;
+    }
+
+    inline bool read_uint64(uint64_t *res)
+    {
+        if (ptr == end or *ptr < '0' or *ptr > '9') return false;
+#ifdef PG_SIMD
+        if (end - ptr >= SCAN) {
+            // only if the number ends in the block (otherwise it has at least SCAN digits)
+            uint32_t m = ~scan_range(ptr, '0', 9) & SCAN_MASK;
+            int len = m ? __builtin_ctz(m) : SCAN;
+            if (len == SCAN) { /* scalar loop */ }
+            else if (len <= 8) {
+                *res = convert_digits8(ptr, len);
+                ptr += len;
+                return true;
+            } else if (len <= 16) {
+                *res = convert_digits8(ptr, len-8) * 100000000ULL + convert_digits8(ptr+len-8, 8);
+                ptr += len;
+                return true;
+            }
+        }
+#endif
+        uint64_t r = 0;
+        while (ptr != end and *ptr >= '0' and *ptr <= '9') {
+            if (r > (UINT64_MAX-9)/10) return false; // too many digits
+            r = (10*r)+(*ptr++-'0');
+        }
+        *res = r;
+        return true;
+    }
+
+    inline bool read_char(char *ch)
+    {
+        skip_whitespace();
+        if (ptr == end) return false;
+        *ch = *ptr++;
+        return true;
+    }
+};
+
+/**
+ * Parse all nodes in the chunk.
+ * Claims each node in <seen> (storing 1+owner) to detect duplicate ids.
+ */
+static void
+parse_chunk(pgchunk &c, int n_nodes, int *priority, char *seen)
+{
+    for (;;) {
+        uint64_t id, n;
+        c.skip_whitespace();
+        if (c.ptr == c.end) return;
+        if (!c.read_uint64(&id)) { c.error = "unable to read id"; return; }
+        if (id >= (uint64_t)n_nodes) { c.error = "invalid id"; return; }
+
+        c.skip_whitespace();
+        if (!c.read_uint64(&n)) { c.error = "missing priority"; return; }
+        if (n >= INT32_MAX) { c.error = "invalid priority"; return; }
+        priority[id] = n;
+
+        c.skip_whitespace();
+        if (!c.read_uint64(&n)) { c.error = "missing owner"; return; }
+        if (n != 0 and n != 1) { c.error = "invalid owner"; return; }
+
+        if (!__sync_bool_compare_and_swap(&seen[id], 0, (char)(1+n))) { c.error = "duplicate id"; return; }
+
+        // parse successors and optional label
+        int deg = 0;
+        for (;;) {
+            c.skip_whitespace();
+            if (!c.read_uint64(&n)) { c.error = "missing successor"; return; }
+            if (n >= (uint64_t)n_nodes) { c.error = "invalid successor"; return; }
+            c.succs.push_back(n);
+            deg++;
+
+            char ch;
+            if (!c.read_char(&ch)) { c.error = "missing ; to end line"; return; }
+            if (ch == ',') continue; // next successor
+            if (ch == ';') break; // end of line
+            if (ch == '\"') {
+                while (true) {
+                    if (!c.read_char(&ch)) { c.error = "missing ; to end line"; return; }
+                    if (ch == '\"') break;
+                    c.labels += ch;
+                }
+                c.label_ends.push_back(std::make_pair((int)id, c.labels.size()));
+                // now read ;
+                if (!c.read_char(&ch) or ch != ';') { c.error = "missing ; to end line"; return; }
+            }
+            break;
+        }
+
+        c.nodes.push_back(id);
+        c.degs.push_back(deg);
+    }
+}
+
+/**
+ * Find the end of the first line in [<split>,<end>) that ends with a ';'.
+ * (The ';' is searched no further back than <pos>.)
+ * Returns the position after the newline, or <end> if there is none.
+ */
+static const char*
+find_line_end(const char *pos, const char *split, const char *end)
+{
+    while (split != end) {
+        if (*split++ != '\n') continue;
+        const char *prev = split-1;
+        while (prev != pos and is_whitespace(*prev)) prev--;
+        if (*prev == ';') break;
+    }
+    return split;
+}
+
+/**
+ * Find the end of the last line in [<begin>,<end>) that ends with a ';'.
+ * Returns the position after the newline, or <begin> if there is none.
+ */
+static const char*
+find_last_line_end(const char *begin, const char *end)
+{
+    for (const char *p = end; p != begin; p--) {
+        if (p[-1] != '\n') continue;
+        const char *prev = p-1;
+        while (prev != begin and is_whitespace(*prev)) prev--;
+        if (*prev == ';') return p;
+    }
+    return begin;
+}
+
+/**
+ * Parse the header line "parity <n>;" and return <n>.
+ */
+static uint64_t
+parse_header(pgchunk &hdr)
+{
+    uint64_t n;
+    char ch = 0;
+
+    if (hdr.end - hdr.ptr < 6 or strncmp(hdr.ptr, "parity", 6) != 0) throw "expecting parity game specification";
+    hdr.ptr += 6;
+
+    hdr.skip_whitespace();
+    if (!hdr.read_uint64(&n)) throw "missing number of nodes";
+
+    while (hdr.read_char(&ch) and ch != ';') continue;
+    if (ch != ';') throw "missing ';'";
+
+    if (n >= INT32_MAX) throw "too many nodes";
+    return n;
+}
+
+/**
+ * Build the game <g> from the parsed <chunks>, using <threads> threads.
+ * <g> was constructed with the (maximum) number of nodes, <seen> has 1+owner for every parsed node.
+ */
+static void
+build_game(Game &g, std::vector<pgchunk> &chunks, char *seen, int threads)
+{
+    size_t node_count = 0;
+    for (auto &c : chunks) node_count += c.nodes.size();
+    if (node_count == (size_t)g.n_nodes-1 and seen[g.n_nodes-1] == 0) {
+        // the header encodes the number of nodes
+        g.n_nodes--;
+        g.solved.resize(g.n_nodes);
+        g.winner.resize(g.n_nodes);
+        g.owner.resize(g.n_nodes);
+    }
+
+    for (int i=0; i<g.n_nodes; i++) {
+        if (seen[i] == 0) throw "missing nodes";
+        if (seen[i] == 2) g.owner[i] = true;
+    }
+
+    // move the labels (if any) into the label pool
+    for (auto &c : chunks) {
+        size_t start = 0;
+        for (auto &l : c.label_ends) {
+            g.label.set(l.first, c.labels.data() + start, l.second - start);
+            start = l.second;
+        }
+        std::string().swap(c.labels);
+    }
+
+    /**
+     * Build the CSR arrays...
+     */
+
+    const int n_nodes = g.n_nodes;
+    threads = (int)std::max((size_t)1, std::min((size_t)threads, chunks.size()));
+    free_array(g.outs);
+    free_array(g.ins);
+    g.outs = g.ins = NULL;
+    memset(g.ina, 0, sizeof(edge_offset[n_nodes+1]));
+
+    // (chunks are divided over the threads round robin)
+    run_threads(threads, [&] (int t) {
+        for (size_t k=t; k<chunks.size(); k+=threads) {
+            pgchunk &c = chunks[k];
+            for (size_t i=0; i<c.nodes.size(); i++) g.outa[c.nodes[i]] = c.degs[i];
+            for (int to : c.succs) {
+                if (to >= n_nodes) { c.error = "invalid successor"; return; }
+                __sync_fetch_and_add(&g.ina[to], 1);
+            }
+        }
+    });
+    for (auto &c : chunks) {
+        if (c.error != NULL) throw c.error;
+    }
+
+    prefix_sum(g.outa, n_nodes, threads);
+    prefix_sum(g.ina, n_nodes, threads);
+
+    g.outs = alloc_array<int>(g.outa[n_nodes]);
+    g.ins = alloc_array<int>(g.ina[n_nodes]);
+    g.n_edges = g.outa[n_nodes] - n_nodes;
+
+    std::vector<edge_offset> cursor(g.ina, g.ina + n_nodes);
+
+    // copy the successors (in input order) and fill predecessors
+    run_threads(threads, [&] (int t) {
+        for (size_t k=t; k<chunks.size(); k+=threads) {
+            pgchunk &c = chunks[k];
+            const int *succ = c.succs.data();
+            for (size_t i=0; i<c.nodes.size(); i++) {
+                const int from = c.nodes[i];
+                int *_out = g.outs + g.outa[from];
+                for (int j=0; j<c.degs[i]; j++) {
+                    const int to = *succ++;
+                    *_out++ = to;
+                    g.ins[__sync_fetch_and_add(&cursor[to], 1)] = from;
+                }
+                *_out = -1;
+            }
+            std::vector<int>().swap(c.succs);
+        }
+    });
+
+    // terminate and sort predecessors (order of in-edges does not depend on the threads)
+    run_threads(threads, [&] (int t) {
+        int from, to;
+        thread_block(n_nodes, t, threads, &from, &to);
+        for (int i=from; i<to; i++) {
+            std::sort(g.ins + g.ina[i], g.ins + g.ina[i+1] - 1);
+            g.ins[g.ina[i+1]-1] = -1;
+        }
+    });
+}
+
+void
+Game::parse_pgsolver(const char *data, size_t len, int workers)
+{
+    const char *end = data + len;
+    pgchunk hdr;
+    hdr.ptr = data;
+    hdr.end = end;
+
+    /**
+     * Read header line...
+     */
+
+    uint64_t n = parse_header(hdr);
+
+    /**
+     * Split the remainder in chunks that end at the end of a line with a ';'
+     */
+
+    const size_t body = end - hdr.ptr;
+    const int threads = thread_count(workers, body, 1<<20); // at least 1 MB per thread
+
+    std::vector<pgchunk> chunks(threads);
+    const char *pos = hdr.ptr;
+    for (int t=0; t<threads; t++) {
+        const char *split = t == threads-1 ? end : hdr.ptr + (body * (t+1)) / threads;
+        split = find_line_end(pos, std::max(split, pos), end);
+        chunks[t].ptr = pos;
+        chunks[t].end = split;
+        chunks[t].error = NULL;
+        pos = split;
+    }
+
+    /**
+     * Construct game...
+     */
+
+    Game g(n+1); // plus 1, in case this parity game encodes "max id" instead of "n_nodes"
+    std::vector<char> seen(g.n_nodes, 0);
+
+    /**
+     * Read nodes...
+     */
+
+    run_threads(threads, [&] (int t) {
+        parse_chunk(chunks[t], g.n_nodes, g.priority, seen.data());
+    });
+
+    for (auto &c : chunks) {
+        if (c.error != NULL) throw c.error;
+    }
+
+    build_game(g, chunks, seen.data(), threads);
+    swap(g);
+}
+
+void
+Game::parse_pgsolver(const std::function<bool(std::string&)> &next, int workers)
+{
+    std::string carry, buf;
+
+    /**
+     * Read header line...
+     */
+
+    while (carry.find(';') == std::string::npos and next(buf)) carry.append(buf);
+
+    pgchunk hdr;
+    hdr.ptr = carry.data();
+    hdr.end = carry.data() + carry.size();
+    uint64_t n = parse_header(hdr);
+    carry.erase(0, hdr.ptr - carry.data());
+
+    /**
+     * Construct game...
+     */
+
+    Game g(n+1); // plus 1, in case this parity game encodes "max id" instead of "n_nodes"
+    std::vector<char> seen(g.n_nodes, 0);
+    std::vector<pgchunk> chunks;
+
+    auto parse = [&] (const char *ptr, const char *end) {
+        chunks.emplace_back();
+        pgchunk &c = chunks.back();
+        c.ptr = ptr;
+        c.end = end;
+        c.error = NULL;
+        parse_chunk(c, g.n_nodes, g.priority, seen.data());
+        if (c.error != NULL) throw c.error;
+    };
+
+    /**
+     * Read nodes, block by block; a line that spans blocks is carried over...
+     */
+
+    while (next(buf)) {
+        const char *data = buf.data();
+        const char *end = data + buf.size();
+        const char *split = find_last_line_end(data, end);
+        if (split == data) {
+            carry.append(buf);
+            continue;
+        }
+        if (!carry.empty()) {
+            const char *first = find_line_end(data, data, split);
+            carry.append(data, first);
+            parse(carry.data(), carry.data() + carry.size());
+            data = first;
+        }
+        if (data != split) parse(data, split);
+        carry.assign(split, end);
+    }
+    if (!carry.empty()) parse(carry.data(), carry.data() + carry.size());
+
+    build_game(g, chunks, seen.data(), thread_count(workers, chunks.size(), 1));
+    swap(g);
+}
+
+void
+Game::load_pgsolver(const char *filename, int workers)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) throw "unable to open file";
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); throw "unable to open file"; }
+    const size_t size = st.st_size;
+    if (size == 0) { close(fd); throw "expecting parity game specification"; }
+
+    void *ptr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) throw "unable to map file";
+    madvise(ptr, size, MADV_SEQUENTIAL);
+
+    try {
+        parse_pgsolver((const char*)ptr, size, workers);
+    } catch (...) {
+        munmap(ptr, size);
+        throw;
+    }
+    munmap(ptr, size);
+}
+
+}
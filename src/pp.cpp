@@ -210,7 +210,7 @@ PPSolver::getRegionStatus(int i, int p)
         } else {
             // region lost by escape owner
             // it is therefore closed if there are no edges to lower regions
-            for (int to : out[j]) {
+            for (int to : out(j)) {
                 if (disabled[to]) continue;
                 if (region[to] < p) return -2; // open
             }
@@ -221,7 +221,7 @@ PPSolver::getRegionStatus(int i, int p)
     for (int j : regions[p]) {
         if (owner[j] != pl) {
             // losing node, find lowest higher ...
-            for (int to : out[j]) {
+            for (int to : out(j)) {
                 /** HOT SPOT of the iterator and minor hot spot of obtaining the region **/
                 if (disabled[to]) continue;
                 int r = region[to];
@@ -249,7 +249,7 @@ PPSolver::reportRegion(int p)
             }
         } else {
             bool got = false;
-            for (int to : out[n]) {
+            for (int to : out(n)) {
                 if (disabled[to]) continue;
                 if (region[to] == -2) continue;
                 if (region[to] == p) continue;
@@ -360,7 +360,7 @@ PPSolver::printState()
             logger << "\033[1m" << priority[j] << "\033[m ";
             if (owner[j] == (p&1)) {
                 bool escapes = true;
-                for (int to : out[j]) {
+                for (int to : out(j)) {
                     if (region[to] == -2) continue;
                     if (region[to] == p) {
                         escapes = false;
@@ -368,14 +368,14 @@ PPSolver::printState()
                     }
                 }
                 if (escapes) {
-                    for (int to : out[j]) {
+                    for (int to : out(j)) {
                         if (region[to] == -2) continue;
                         logger << "\033[m" << region[to] << "\033[m ";
                         if (region[to] != p) exits.push_back(region[to]);
                     }
                 }
             } else {
-                for (int to : out[j]) {
+                for (int to : out(j)) {
                     if (region[to] == -2) continue;
                     logger << "\033[m" << region[to] << "\033[m ";
                     if (region[to] != p) exits.push_back(region[to]);
@@ -406,7 +406,7 @@ PPSolver::printState()
                 // node won by escape owner
                 // it is therefore closed if it has an edge to itself
                 bool nodeclosed = false;
-                for (int to : out[j]) {
+                for (int to : out(j)) {
                     if (region[to] == p) nodeclosed = true;
                     if (nodeclosed) break;
                 }
@@ -414,7 +414,7 @@ PPSolver::printState()
             } else {
                 // region lost by escape owner
                 // it is therefore closed if there are no edges to lower regions
-                for (int to : out[j]) {
+                for (int to : out(j)) {
                     if (region[to] == -2) continue;
                     if (region[to] != p) {
                         fullclosed = false;
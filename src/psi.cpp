@@ -18,6 +18,7 @@
 
 #include "psi.hpp"
 #include "lace.h"
+#include "parallel.hpp"
 #include "printf.hpp"
 
 namespace pg {
@@ -346,28 +347,13 @@ PSISolver::print_debug()
 }
 
 /**
- * Run the parallel strategy improvement solver
+ * Initialize the valuation and strategy of nodes <begin> ... <end>-1.
  */
 void
-PSISolver::run()
+PSISolver::init_nodes(int begin, int end)
 {
-    // determine k as highest priority + 1
-    k = 0;
-    for (int i=0; i<n_nodes; i++) if (!disabled[i] && priority[i]>k) k = priority[i];
-    k++;
-
-    // now create the data structure
-    val = new int[k*n_nodes];
-    str = new int[n_nodes];
-    done = new int[n_nodes];
-    won = new int[n_nodes];
-
-    first_in = new int[n_nodes];
-    next_in = new int[n_nodes];
-
-    // initialize the datastructure
-    for (int i=0; i<k*n_nodes; i++) val[i] = 0;
-    for (int i=0; i<n_nodes; i++) {
+    memset(val + (size_t)k*begin, 0, sizeof(int[(size_t)k*(end-begin)]));
+    for (int i=begin; i<end; i++) {
         if (disabled[i]) {
             str[i] = -2; // set to "disabled sink"
             done[i] = 3; // set to "disabled/won"
@@ -393,6 +379,43 @@ PSISolver::run()
             val[k*i+priority[i]] = 1;
         }
     }
+}
+
+VOID_TASK_1(init_nodes_par, PSISolver*, s)
+{
+    // every worker initializes its own block of nodes
+    int begin, end;
+    thread_block(s->n_nodes, LACE_WORKER_ID, lace_workers(), &begin, &end);
+    s->init_nodes(begin, end);
+}
+
+/**
+ * Run the parallel strategy improvement solver
+ */
+void
+PSISolver::run()
+{
+    // determine k as highest priority + 1
+    k = 0;
+    for (int i=0; i<n_nodes; i++) if (!disabled[i] && priority[i]>k) k = priority[i];
+    k++;
+
+    // now create the data structure
+    val = alloc_array<int>((size_t)k*n_nodes);
+    str = new int[n_nodes];
+    done = new int[n_nodes];
+    won = new int[n_nodes];
+
+    first_in = new int[n_nodes];
+    next_in = new int[n_nodes];
+
+    // initialize the datastructure (in parallel, so every worker first-touches the memory of its nodes)
+    if (lace_workers() == 0) {
+        init_nodes(0, n_nodes);
+    } else {
+        LACE_ME;
+        TOGETHER(init_nodes_par, this);
+    }
 
     if (lace_workers() == 0) {
         for (;;) {
@@ -439,7 +462,7 @@ PSISolver::run()
         oink->solve(i, winner, game->owner[i] == winner ? str[i] : -1);
     }
 
-    delete[] val;
+    free_array(val);
     delete[] str;
     delete[] done;
     delete[] won;
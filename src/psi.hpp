@@ -41,10 +41,12 @@ public:
     bool si_val_less(int a, int b);
     void print_debug();
 
+    void init_nodes(int begin, int end);
     void compute_vals_seq(void);
     int mark_solved_seq(void);
     int switch_strategy_seq(int pl);
 
+    friend void init_nodes_par_WORK(_WorkerP*, _Task*, PSISolver*);
     friend void compute_val_WORK(_WorkerP*, _Task*, int, PSISolver*);
     friend void compute_all_val_WORK(_WorkerP*, _Task*, PSISolver*);
     friend int mark_solved_rec_WORK(_WorkerP*, _Task*, PSISolver*, int, int);
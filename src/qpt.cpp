@@ -231,7 +231,7 @@ QPTSolver::try_lift(int n, std::vector<int> &vec)
     if (owner[n] == 0) {
         // in Ve so max!
         bool first = true;
-        for (int to : out[n]) {
+        for (int to : out(n)) {
             if (disabled[to]) continue; // not looking at this
             au(tmp, pm_nodes + k*to, priority[n], k);
 
@@ -249,7 +249,7 @@ QPTSolver::try_lift(int n, std::vector<int> &vec)
     } else {
         // in Vo so min!
         bool first = true;
-        for (int to : out[n]) {
+        for (int to : out(n)) {
             if (disabled[to]) continue; // not looking at this
             au(tmp, pm_nodes + k*to, priority[n], k);
 
@@ -284,7 +284,7 @@ QPTSolver::lift(int n)
     if (owner[n] == 0) {
         // in Ve so max!
         // compute au for each successor and if it's larger, take it
-        for (int to : out[n]) {
+        for (int to : out(n)) {
             if (disabled[to]) continue; // not looking at this
             au(tmp, pm_nodes + k*to, priority[n], k);
 
@@ -304,7 +304,7 @@ QPTSolver::lift(int n)
         // compute au for each successor and if it's smaller, take it
         bool first = true;
         int best_to = -1;
-        for (int to : out[n]) {
+        for (int to : out(n)) {
             if (disabled[to]) continue; // not looking at this
             au(tmp, pm_nodes + k*to, priority[n], k);
 
@@ -356,7 +356,7 @@ QPTSolver::liftR(int node, int target)
         bool first = true;
         int best_to = -1;
         int tmp[k], res[k];
-        for (int to : out[node]) {
+        for (int to : out(node)) {
             if (disabled[to]) continue; // not looking at this
             au(tmp, pm_nodes + k*to, priority[node], k);
             if (first || pm_less(tmp, res, k)) {
@@ -408,7 +408,7 @@ QPTSolver::run()
     }
 
     // now create the data structure, for each node
-    pm_nodes = new int[k*n_nodes];
+    pm_nodes = alloc_array<int>((size_t)k*n_nodes);
     for (int i=0; i<k*n_nodes; i++) pm_nodes[i] = -1; // initialize all to _
 
     strategy = new int[n_nodes];
@@ -453,7 +453,7 @@ QPTSolver::run()
                 if (lift(n)) {
                     if (dirty[n]) dirty[n] = 0;
                     lift_count++;
-                    for (int from : in[n]) {
+                    for (int from : in(n)) {
                         if (disabled[from]) continue;
                         lift_attempt++;
                         if (!liftR(from, n)) continue;
@@ -478,7 +478,7 @@ QPTSolver::run()
                 if ((lift_count % n_nodes) == 0) {
                     if (trace) logger << "\033[1;38;5;208mIteration " << (lift_count / n_nodes) << "\033[m" << std::endl;
                 }
-                for (int from : in[n]) {
+                for (int from : in(n)) {
                     if (disabled[from]) continue;
                     lift_attempt++;
                     if (!liftR(from, n)) continue;
@@ -511,7 +511,7 @@ QPTSolver::run()
                 if (lift(n)) {
                     if (dirty[n]) dirty[n] = 0;
                     lift_count++;
-                    for (int from : in[n]) {
+                    for (int from : in(n)) {
                         if (disabled[from]) continue;
                         lift_attempt++;
                         if (!liftR(from, n)) continue;
@@ -531,7 +531,7 @@ QPTSolver::run()
                     if (!dirty[n]) continue; // not dirty, continue
                     dirty[n] = 0; // unmark
 
-                    for (int from : in[n]) {
+                    for (int from : in(n)) {
                         if (disabled[from]) continue;
                         lift_attempt++;
                         if (!liftR(from, n)) continue;
@@ -559,7 +559,7 @@ QPTSolver::run()
             lift_attempt++;
             if (lift(n)) {
                 lift_count++;
-                for (int from : in[n]) {
+                for (int from : in(n)) {
                     if (disabled[from] || dirty[from]) continue;
                     dirty[from] = 1;
                     todo.push_back(from);
@@ -586,7 +586,7 @@ QPTSolver::run()
                 }
 
                 lift_count++;
-                for (int from : in[n]) {
+                for (int from : in(n)) {
                     if (disabled[from] || dirty[from]) continue;
                     dirty[from] = 1;
                     todo.push_back(from);
@@ -622,7 +622,7 @@ QPTSolver::run()
                     }
                     lift_count++;
                     changed = true;
-                    for (int from : in[n]) dirty[from] = 1;
+                    for (int from : in(n)) dirty[from] = 1;
                 }
             }
             first_round = false;
@@ -638,7 +638,7 @@ QPTSolver::run()
         oink->solve(i, winner, (game->owner[i] == 1 && winner == 1) ? strategy[i] : -1);
     }
 
-    delete[] pm_nodes;
+    free_array(pm_nodes);
     delete[] strategy;
 
     logger << "solved with " << lift_count << " lifts, " << lift_attempt << " lift attempts." << std::endl;
@@ -63,7 +63,7 @@ RRSolver::checkRegion(int p)
         } else /*if (priority[j] != p)*/ {
             // not-top loser
             // check if it can escape in the subgame
-            for (auto to : out[j]) {
+            for (auto to : out(j)) {
                 // it may be able to escape to a lower region if there have been resets
                 if (region[to] != -2 && region[to] < p) return false;
             }
@@ -48,7 +48,7 @@ Oink::tarjan(int n, std::vector<int> &res, bool nonempty)
         }
         int min = low[idx];
         bool pushed = false;
-        for (auto to_idx : game->out[idx]) {
+        for (auto to_idx : game->out(idx)) {
             if (disabled[to_idx]) continue;
             if (low[to_idx] == 0) {
                 // not visited
@@ -74,7 +74,7 @@ Oink::tarjan(int n, std::vector<int> &res, bool nonempty)
          */
 
         if (nonempty) {
-            auto &out_idx = game->out[idx];
+            auto out_idx = game->out(idx);
             if (res.back() == idx and std::find(out_idx.begin(), out_idx.end(), idx) == out_idx.end()) {
                 // it has no edges!
                 res.pop_back();
@@ -92,6 +92,77 @@ Oink::tarjan(int n, std::vector<int> &res, bool nonempty)
     delete[] low;
 }
 
+/**
+ * Compute all SCCs of the subgame of nodes that are not disabled, in reverse topological order.
+ * This is the iterative variant of Tarjan's algorithm by Pearce, which uses one array for the
+ * dfs numbers and the lowlinks; the dfs number of a node on the call stack is kept in its frame.
+ */
+void
+Oink::getSCCs(std::vector<int> &nodes, std::vector<int> &index)
+{
+    struct frame { int node; int pre; edge_offset next; };
+
+    const int n_nodes = game->n_nodes;
+    std::vector<int> low(n_nodes, 0); // 0 for unvisited, -1 for assigned to an SCC
+    std::vector<int> st;              // nodes not yet assigned to an SCC
+    std::vector<frame> cs;            // call stack
+    int pre = 0;
+
+    nodes.clear();
+    index.clear();
+    index.push_back(0);
+
+    for (int root=0; root<n_nodes; root++) {
+        if (disabled[root] or low[root] != 0) continue;
+
+        low[root] = ++pre;
+        st.push_back(root);
+        cs.push_back({root, pre, game->outa[root]});
+
+        while (!cs.empty()) {
+            frame &f = cs.back();
+            const int v = f.node;
+
+            // continue with the next successor
+            bool pushed = false;
+            for (int to = game->outs[f.next]; to != -1; to = game->outs[++f.next]) {
+                if (disabled[to]) continue;
+                if (low[to] == 0) {
+                    // not visited, push it (invalidates <f>)
+                    f.next++;
+                    low[to] = ++pre;
+                    st.push_back(to);
+                    cs.push_back({to, pre, game->outa[to]});
+                    pushed = true;
+                    break;
+                }
+                // visited and not in an SCC yet, update lowlink
+                if (low[to] > 0 and low[to] < low[v]) low[v] = low[to];
+            }
+            if (pushed) continue;
+
+            const int v_pre = f.pre;
+            cs.pop_back();
+
+            if (low[v] == v_pre) {
+                // <v> is the root of an SCC, which consists of all nodes on <st> from <v>
+                int w;
+                do {
+                    w = st.back();
+                    st.pop_back();
+                    low[w] = -1;
+                    nodes.push_back(w);
+                } while (w != v);
+                index.push_back(nodes.size());
+            } else {
+                // update the lowlink of the caller
+                const int u = cs.back().node;
+                if (low[v] < low[u]) low[u] = low[v];
+            }
+        }
+    }
+}
+
 /**
  * Find a bottom SCC starting from the first unsolved node.
  */
@@ -19,6 +19,7 @@
 
 #include "game.hpp"
 #include "oink.hpp"
+#include <cassert>
 #include <signal.h>
 
 #define LOGIC_ERROR { printf("\033[1;7mlogic error %s:%d!\033[m\n", __FILE__, __LINE__); raise(SIGABRT); }
@@ -31,9 +32,10 @@ public:
     Solver(Oink *oink, Game *game) :
             oink(oink), game(game), logger(oink->logger), trace(oink->trace),
             n_nodes(game->n_nodes), priority(game->priority), owner(game->owner),
-            out(game->out), in(game->in), disabled(oink->disabled),
-            outa(oink->outa), ina(oink->ina), outs(oink->outs), ins(oink->ins)
+            disabled(oink->disabled),
+            outa(game->outa), ina(game->ina), outs(game->outs), ins(game->ins)
     {
+        assert(game->isBuilt());
 #ifndef NDEBUG
         // sanity check if the game is properly sorted
         for (int i=1; i<n_nodes; i++) assert(priority[i-1] <= priority[i]);
@@ -43,6 +45,13 @@ public:
     virtual ~Solver() { }
     virtual void run() = 0;
 
+    /**
+     * Solve the game again after run(), when Oink has disabled the nodes that are solved since,
+     * reusing the allocations of the solver. Returns false if the solver does not support this;
+     * then Oink constructs a new solver instead.
+     */
+    virtual bool resolve() { return false; }
+
 protected:
     Oink *oink;
     Game *game;
@@ -52,14 +61,15 @@ protected:
     const int n_nodes;
     const int * const priority;
     const bitset &owner;
-    const std::vector<int> * const out;
-    const std::vector<int> * const in;
     const bitset &disabled;
 
-    const int* const outa;
-    const int* const ina;
+    const edge_offset* const outa;
+    const edge_offset* const ina;
     const int* const outs;
     const int* const ins;
+
+    inline edge_range out(int node) const { return edge_range(outs + outa[node]); }
+    inline edge_range in(int node) const { return edge_range(ins + ina[node]); }
 };
 
 }
@@ -34,10 +34,31 @@ namespace pg {
 
 SPMSolver::SPMSolver(Oink *oink, Game *game) : Solver(oink, game)
 {
+    // determine k = highest priority + 1
+    k = n_nodes == 0 ? 0 : priority[n_nodes-1]+1;
+    if (k < 2) k = 2;
+
+    // now create the data structure, for each node (for every run)
+    pms = alloc_array<int>((size_t)k*n_nodes);
+    strategy = new int[n_nodes];
+    counts = new int[k];
+    tmp = new int[k];
+    best = new int[k];
+    dirty = new int[n_nodes];
+    unstable = new int[n_nodes];
+    cm = new int[n_nodes];
 }
 
 SPMSolver::~SPMSolver()
 {
+    free_array(pms);
+    delete[] strategy;
+    delete[] counts;
+    delete[] tmp;
+    delete[] best;
+    delete[] dirty;
+    delete[] cm;
+    delete[] unstable;
 }
 
 /**
@@ -138,7 +159,7 @@ SPMSolver::canlift(int node, int pl)
 
     if (owner[node] == pl) {
         // do max
-        for (int to : out[node]) {
+        for (int to : out(node)) {
             if (disabled[to]) continue;
             Prog(tmp, pms + k*to, d, pl);
             if (pm_less(pm, tmp, d, pl)) return true;
@@ -147,7 +168,7 @@ SPMSolver::canlift(int node, int pl)
     } else {
         // do min
         int best_to = -1;
-        for (int to : out[node]) {
+        for (int to : out(node)) {
             if (disabled[to]) continue;
             Prog(tmp, pms + k*to, d, pl);
             if (best_to == -1 or pm_less(tmp, best, d, pl)) {
@@ -209,7 +230,7 @@ SPMSolver::lift(int node, int target)
                 if (pl_max) best_ch1 = target;
                 else best_ch0 = target;
             }
-        } else for (int to : out[node]) {
+        } else for (int to : out(node)) {
             if (disabled[to]) continue;
             Prog(tmp, pms + k*to, d, pl_max);
 #ifndef NDEBUG
@@ -234,7 +255,7 @@ SPMSolver::lift(int node, int target)
         if (trace >= 2) pm_copy(tmp, pm, 1-pl_min);
 #endif
         int best_to = -1;
-        for (int to : out[node]) {
+        for (int to : out(node)) {
             if (disabled[to]) continue;
             Prog(tmp, pms + k*to, d, pl_min);
 #ifndef NDEBUG
@@ -292,12 +313,12 @@ SPMSolver::update(int pl)
     while (!q.empty()) {
         int n = q.front();
         q.pop();
-        for (int m : in[n]) {
+        for (int m : in(n)) {
             if (disabled[m] or unstable[m]) continue;
             if (owner[m] != pl) {
                 int best_to = -1;
                 const int d = priority[m];
-                for (int to : out[m]) {
+                for (int to : out(m)) {
                     if (disabled[to]) continue;
                     if (unstable[to]) continue;
                     Prog(tmp, pms + k*to, d, pl);
@@ -332,27 +353,41 @@ SPMSolver::update(int pl)
 void
 SPMSolver::run()
 {
-    // determine k = highest priority + 1
-    k = priority[n_nodes-1]+1;
-    if (k < 2) k = 2;
-
-    // now create the data structure, for each node
-    pms = new int[(size_t)k*n_nodes];
-    strategy = new int[n_nodes];
-    counts = new int[k];
-    tmp = new int[k];
-    best = new int[k];
-    dirty = new int[n_nodes];
-    unstable = new int[n_nodes];
-
-    int max0 = -1, max1 = -1;
-
     // initialize all measures to 0
     for (int i=0; i<k*n_nodes; i++) pms[i] = 0;
 
     // initialize strategy to -1
     for (int i=0; i<n_nodes; i++) strategy[i] = -1;
 
+    // initialize all nodes as not dirty
+    for (int n=0; n<n_nodes; n++) dirty[n] = 0;
+
+    // initialize additional array for cycle measures
+    for (int n=0; n<n_nodes; n++) cm[n] = 0;
+
+    solve();
+}
+
+bool
+SPMSolver::resolve()
+{
+    // only the measures and strategies of enabled nodes are used, reset those;
+    // after a run, all nodes are not dirty and have no cycle measure
+    for (int n=0; n<n_nodes; n++) {
+        if (disabled[n]) continue;
+        for (int i=0; i<k; i++) pms[k*n+i] = 0;
+        strategy[n] = -1;
+    }
+
+    solve();
+    return true;
+}
+
+void
+SPMSolver::solve()
+{
+    int max0 = -1, max1 = -1;
+
     // initialize counts for each priority
     for (int i=0; i<k; i++) counts[i] = 0;
     for (int i=0; i<n_nodes; i++) if (disabled[i] == 0) counts[priority[i]]++;
@@ -363,13 +398,6 @@ SPMSolver::run()
         if (max0 != -1 and max0 != -1) break;
     }
 
-    // initialize all nodes as not dirty
-    for (int n=0; n<n_nodes; n++) dirty[n] = 0;
-
-    // allocate and initialize additional array for cycle measures
-    int *cm = new int[n_nodes];
-    for (int n=0; n<n_nodes; n++) cm[n] = 0;
-
     // a queue and a vector for cycle measure analysis
     std::queue<int> cm_queue;
     std::vector<int> cycles;
@@ -388,7 +416,7 @@ SPMSolver::run()
 
     for (int n=n_nodes-1; n>=0; n--) {
         if (!disabled[n] and lift(n, -1)) {
-            for (int from : in[n]) if (!disabled[from] and lift(from, n)) todo_push(from);
+            for (int from : in(n)) if (!disabled[from] and lift(from, n)) todo_push(from);
         }
     }
     
@@ -401,7 +429,7 @@ SPMSolver::run()
     while (true) {
         while (!todo.empty()) {
             int n = todo_pop();
-            for (int from : in[n]) if (!disabled[from] and lift(from, n)) todo_push(from);
+            for (int from : in(n)) if (!disabled[from] and lift(from, n)) todo_push(from);
             if (last_update + 10*n_nodes < lift_count) {
                 last_update = lift_count;
                 update(0);
@@ -469,7 +497,7 @@ SPMSolver::run()
                 cycles.push_back(n);
                 if (owner[n] != pl) {
                     const int d = priority[n];
-                    for (int to : out[n]) {
+                    for (int to : out(n)) {
                         if (disabled[to]) continue;
                         int *pm_to = pms + k*to;
                         if (pm_to[pl] == -1) continue; // already won
@@ -510,7 +538,7 @@ SPMSolver::run()
                     if (owner[n] == pl) {
                         // check if it can stay in cm
                         escapes = true;
-                        for (int m : out[n]) {
+                        for (int m : out(n)) {
                             if (disabled[m] == 0 and cm[m]) {
                                 escapes = false;
                                 break;
@@ -519,7 +547,7 @@ SPMSolver::run()
                     } else {
                         // check if it can move out of cm
                         escapes = false;
-                        for (int m : out[n]) {
+                        for (int m : out(n)) {
                             if (disabled[m] == 0 and pms[k*m+pl] != -1 and cm[m] == 0) {
                                 escapes = true;
                                 break;
@@ -539,11 +567,11 @@ SPMSolver::run()
                 while (!cm_queue.empty()) {
                     int n = cm_queue.front();
                     cm_queue.pop();
-                    for (int m : in[n]) {
+                    for (int m : in(n)) {
                         if (disabled[m] != 0 or cm[m] == 0) continue;
                         if (owner[m] == pl) {
                             bool escapes = false;
-                            for (int to : out[m]) {
+                            for (int to : out(m)) {
                                 if (disabled[to] == 0 and cm[to]) {
                                     escapes = true;
                                     break;
@@ -610,15 +638,6 @@ SPMSolver::run()
         oink->solve(n, winner, game->owner[n] == winner ? strategy[n] : -1);
     }
 
-    delete[] pms;
-    delete[] strategy;
-    delete[] counts;
-    delete[] tmp;
-    delete[] best;
-    delete[] dirty;
-    delete[] cm;
-    delete[] unstable;
-
     logger << "solved with " << lift_count << " lifts, " << lift_attempt << " lift attempts." << std::endl;
 }
 
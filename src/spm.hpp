@@ -31,6 +31,7 @@ public:
     virtual ~SPMSolver();
 
     virtual void run();
+    virtual bool resolve(); // resets only the measures of the enabled nodes
 
     int64_t lift_attempt = 0;
     int64_t lift_count = 0;
@@ -45,7 +46,9 @@ protected:
     std::deque<int> todo;
     int *dirty;
     int *unstable;
+    int *cm;
 
+    void solve();
     bool canlift(int node, int pl);
     bool lift(int node, int target);
     bool pm_less(int *a, int *b, int d, int pl);
@@ -407,7 +407,7 @@ SSPMSolver::lift_0(int v, int target, int &str)
 
     // compute best measure
     bool first = true;
-    for (int to : out[v]) {
+    for (int to : out(v)) {
         if (disabled[to]) continue;
         to_tmp_0(to);
 #ifndef NDEBUG
@@ -513,7 +513,7 @@ SSPMSolver::lift_1(int v, int target, int &str)
 
     // compute best measure
     bool first = true;
-    for (int to : out[v]) {
+    for (int to : out(v)) {
         if (disabled[to]) continue;
         to_tmp_1(to);
 #ifndef NDEBUG
@@ -659,7 +659,7 @@ SSPMSolver::run()
         lift_attempt++;
         if (lift_0(n, -1, s)) {
             lift_count++;
-            for (int from : in[n]) {
+            for (int from : in(n)) {
                 if (disabled[from]) continue;
                 lift_attempt++;
                 if (lift_0(from, n, s)) {
@@ -672,7 +672,7 @@ SSPMSolver::run()
     
     while (!Q.empty()) {
         int n = todo_pop();
-        for (int from : in[n]) {
+        for (int from : in(n)) {
             if (disabled[from]) continue;
             lift_attempt++;
             if (lift_0(from, n, s)) {
@@ -700,7 +700,7 @@ SSPMSolver::run()
         lift_attempt++;
         if (lift_1(n, -1, s)) {
             lift_count++;
-            for (int from : in[n]) {
+            for (int from : in(n)) {
                 if (disabled[from]) continue;
                 lift_attempt++;
                 if (lift_1(from, n, s)) {
@@ -713,7 +713,7 @@ SSPMSolver::run()
     
     while (!Q.empty()) {
         int n = todo_pop();
-        for (int from : in[n]) {
+        for (int from : in(n)) {
             if (disabled[from]) continue;
             lift_attempt++;
             if (lift_1(from, n, s)) {
@@ -19,6 +19,8 @@
 #include <fstream>
 #include <random>
 
+#include <boost/algorithm/string/predicate.hpp>
+
 #include "cxxopts.hpp"
 #include "game.hpp"
 
@@ -58,7 +60,7 @@ tarjan(Game *game, int n, std::vector<int> &res, bool nonempty)
         }
         int min = low[idx];
         bool pushed = false;
-        for (auto to_idx : game->out[idx]) {
+        for (auto to_idx : game->out(idx)) {
             if (low[to_idx] == 0) {
                 // not visited
                 st.push(to_idx);
@@ -83,7 +85,7 @@ tarjan(Game *game, int n, std::vector<int> &res, bool nonempty)
          */
 
         if (nonempty) {
-            auto &out_idx = game->out[idx];
+            auto out_idx = game->out(idx);
             if (res.back() == idx and std::find(out_idx.begin(), out_idx.end(), idx) == out_idx.end()) {
                 // it has no edges!
                 res.pop_back();
@@ -143,6 +145,7 @@ nudge(Game *game, int profile)
         return true;
     } else if (action == 1) {
         // change priority of the node
+        game->unshare();
         game->priority[n] = rng(0, game->n_nodes*2);
         return true;
     } else if (action == 2) {
@@ -155,10 +158,11 @@ nudge(Game *game, int profile)
         return true;
     } else if (action == 3) {
         // remove the node and forward edges if it has only 1 outgoing edge
-        if (game->out[n].size() == 1 && game->out[n][0] != n) {
-            for (auto &from : game->in[n]) {
+        if (game->out(n).size() == 1 && game->out(n)[0] != n) {
+            game->unbuild(); // edit the builder vectors
+            for (auto &from : game->in(n)) {
                 // add each <to> to <from>
-                for (auto &to : game->out[n]) game->addEdge(from, to);
+                for (auto &to : game->out(n)) game->addEdge(from, to);
             }
             // remove the node
             std::vector<int> tokeep;
@@ -170,30 +174,23 @@ nudge(Game *game, int profile)
         }
     } else if (action == 4) {
         // for one predecessor replace the edge to me by all my edges
-        if (game->in[n].size() > 0) {
-            int from = game->in[n][rng(0, game->in[n].size()-1)];
+        if (game->in(n).size() > 0) {
+            int from = game->in(n)[rng(0, game->in(n).size()-1)];
             if (from != n) {
-                auto &out = game->out[from];
-                out.erase(std::remove(out.begin(), out.end(), n), out.end());
+                game->unbuild(); // edit the builder vectors
+                game->removeEdge(from, n);
 
                 // add each <to> to <from>
-                for (auto &to : game->out[n]) {
-                    if (std::find(game->out[from].begin(), game->out[from].end(), to) == game->out[from].end()) {
-                        game->out[from].push_back(to);
-                        game->in[to].push_back(from);
-                    }
-                }
+                for (auto &to : game->out(n)) game->addEdge(from, to);
                 return true;
             }
         }
     } else if (action == 5) {
         // remove a random edge (if there are outgoing edges to remove)
-        if (game->out[n].size() > 1) {
-            int edge = rng(0, game->out[n].size()-1);
-            int m = game->out[n][edge];
-            game->out[n].erase(game->out[n].begin()+edge);
-            auto &in = game->in[m];
-            in.erase(std::remove(in.begin(), in.end(), n), in.end());
+        if (game->out(n).size() > 1) {
+            int edge = rng(0, game->out(n).size()-1);
+            int m = game->out(n)[edge];
+            game->removeEdge(n, m);
             return true;
         }
     } else if (action == 6) {
@@ -236,7 +233,10 @@ main(int argc, char **argv)
      */
     Game *game;
     try {
-        if (opts.count("input")) {
+        if (opts.count("input") and boost::algorithm::ends_with(opts["input"].as<std::string>(), ".pgb")) {
+            game = new Game();
+            game->load_binary(opts["input"].as<std::string>().c_str());
+        } else if (opts.count("input")) {
             std::ifstream file(opts["input"].as<std::string>());
             game = new Game(file);
             file.close();
@@ -295,7 +295,11 @@ main(int argc, char **argv)
     /**
      * Write to output file or to stdout
      */
-    if (opts.count("output")) {
+    if (opts.count("output") and boost::algorithm::ends_with(opts["output"].as<std::string>(), ".pgb")) {
+        std::ofstream file(opts["output"].as<std::string>(), std::ios_base::binary);
+        game->write_binary(file);
+        file.close();
+    } else if (opts.count("output")) {
         std::ofstream file(opts["output"].as<std::string>());
         game->write_pgsolver(file);
         file.close();
@@ -14,12 +14,20 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <condition_variable>
 #include <csignal>
+#include <cstring>
+#include <deque>
 #include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <mutex>
+#include <thread>
 #include <sys/time.h>
 
+#include <bzlib.h>
+
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
@@ -169,6 +177,276 @@ setsighandlers(void)
 
 /*------------------------------------------------------------------------*/
 
+/**
+ * Bounded queue of decompressed blocks, which are delivered to the parser in order.
+ * Block <idx> is only accepted after all earlier blocks, and only when there is room.
+ */
+class block_queue
+{
+public:
+    block_queue(size_t capacity) : capacity(capacity) { }
+
+    /**
+     * Add block <idx>; returns false if the producers were stopped or the parser is gone.
+     */
+    bool put(size_t idx, std::string &&data)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return closed or stopped or (count == idx and blocks.size() < capacity); });
+        if (closed or stopped) return false;
+        bytes += data.size();
+        count++;
+        blocks.push_back(std::move(data));
+        cond.notify_all();
+        return true;
+    }
+
+    /**
+     * Get the next block; returns false at the end, throws if a producer failed.
+     */
+    bool get(std::string &data)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return !blocks.empty() or done or error != NULL; });
+        if (!blocks.empty()) {
+            data = std::move(blocks.front());
+            blocks.pop_front();
+            cond.notify_all();
+            return true;
+        }
+        if (error != NULL) throw error;
+        return false;
+    }
+
+    void finish() { std::lock_guard<std::mutex> lock(mutex); done = true; cond.notify_all(); }
+    void fail(const char *err) { std::lock_guard<std::mutex> lock(mutex); error = err; cond.notify_all(); }
+    void close() { std::lock_guard<std::mutex> lock(mutex); closed = true; cond.notify_all(); }
+    void stop(bool value) { std::lock_guard<std::mutex> lock(mutex); stopped = value; cond.notify_all(); }
+
+    /**
+     * Number of blocks and bytes accepted so far.
+     */
+    size_t blocks_put() { std::lock_guard<std::mutex> lock(mutex); return count; }
+    size_t bytes_put() { std::lock_guard<std::mutex> lock(mutex); return bytes; }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::string> blocks;
+    size_t capacity;
+    size_t count = 0;           // number of blocks accepted
+    size_t bytes = 0;           // number of bytes accepted
+    bool done = false;          // set after the last block
+    bool closed = false;        // set if the parser is gone
+    bool stopped = false;       // set to reject blocks from the (parallel) producers
+    const char *error = NULL;
+};
+
+static const size_t BLOCK_SIZE = 4 << 20;
+
+/**
+ * Decompress <filename> sequentially into blocks, starting with block <idx>.
+ * The first <skip> bytes of the output are dropped (they were already delivered).
+ */
+static void
+decompress_stream(const std::string &filename, block_queue &queue, size_t idx=0, size_t skip=0)
+{
+    try {
+        io::filtering_istream in;
+        if (boost::algorithm::ends_with(filename, ".bz2")) in.push(io::bzip2_decompressor());
+        if (boost::algorithm::ends_with(filename, ".gz")) in.push(io::gzip_decompressor());
+        std::ifstream file(filename, std::ios_base::binary);
+        in.push(file);
+        for (;;) {
+            std::string block(BLOCK_SIZE, '\0');
+            in.read(&block[0], block.size());
+            block.resize(in.gcount());
+            if (block.empty()) break;
+            if (skip >= block.size()) {
+                skip -= block.size();
+                continue;
+            }
+            block.erase(0, skip);
+            skip = 0;
+            if (!queue.put(idx++, std::move(block))) return;
+        }
+        queue.finish();
+    } catch (...) {
+        queue.fail("unable to decompress");
+    }
+}
+
+static const uint64_t BZ2_BLOCK_MAGIC = 0x314159265359ULL;
+static const uint64_t BZ2_EOS_MAGIC = 0x177245385090ULL;
+
+/**
+ * Read <count> (at most 32) bits of <data> starting at bit <pos> (bzip2 stores bits MSB first).
+ */
+static uint32_t
+get_bits(const std::string &data, size_t pos, int count)
+{
+    uint32_t res = 0;
+    for (int i=0; i<count; i++, pos++) res = (res << 1) | ((data[pos/8] >> (7-pos%8)) & 1);
+    return res;
+}
+
+/**
+ * Find the bit positions of all block (and end of stream) magics of a bzip2 file, with <threads> threads.
+ * The second of each pair is true for a block magic.
+ */
+static std::vector<std::pair<size_t, bool>>
+bz2_find_magics(const std::string &data, int threads)
+{
+    const size_t len = data.size() < 8 ? 0 : data.size() - 7;
+    std::vector<std::vector<std::pair<size_t, bool>>> found(threads);
+    std::vector<std::thread> scanners;
+    for (int t=0; t<threads; t++) {
+        scanners.push_back(std::thread([&, t] {
+            const unsigned char *bytes = (const unsigned char*)data.data();
+            for (size_t p=(len*t)/threads; p<(len*(t+1))/threads; p++) {
+                uint64_t v = 0;
+                for (int i=0; i<8; i++) v = (v << 8) | bytes[p+i];
+                for (int s=0; s<8; s++) {
+                    const uint64_t w = (v >> (16-s)) & 0xffffffffffffULL;
+                    if (w == BZ2_BLOCK_MAGIC) found[t].push_back(std::make_pair(8*p+s, true));
+                    else if (w == BZ2_EOS_MAGIC) found[t].push_back(std::make_pair(8*p+s, false));
+                }
+            }
+        }));
+    }
+    for (auto &scanner : scanners) scanner.join();
+
+    std::vector<std::pair<size_t, bool>> res;
+    for (auto &f : found) res.insert(res.end(), f.begin(), f.end());
+    return res;
+}
+
+/**
+ * Decompress the bzip2 block at bits [<from>,<to>) of <data> into <res>.
+ * The block is wrapped in a stream of its own; its CRC doubles as the stream CRC.
+ * Returns false if this is not a valid block (e.g., a false magic).
+ */
+static bool
+bz2_decompress_block(const std::string &data, size_t from, size_t to, std::string &res)
+{
+    std::string stream = "BZh9"; // the largest block size accepts every block
+    uint64_t acc = 0;
+    int nbits = 0;
+    auto put = [&] (uint32_t value, int count) {
+        acc = (acc << count) | value;
+        nbits += count;
+        while (nbits >= 8) { nbits -= 8; stream.push_back((char)(acc >> nbits)); }
+    };
+
+    const uint32_t crc = get_bits(data, from+48, 32);
+    const int shift = from % 8;
+    const unsigned char *bytes = (const unsigned char*)data.data() + from/8;
+    for (size_t k=0; k<(to-from)/8; k++, bytes++) {
+        put(shift == 0 ? bytes[0] : ((bytes[0] << shift) | (bytes[1] >> (8-shift))) & 0xff, 8);
+    }
+    put(get_bits(data, to - (to-from)%8, (to-from)%8), (to-from)%8);
+    put(BZ2_EOS_MAGIC >> 24, 24);
+    put(BZ2_EOS_MAGIC & 0xffffff, 24);
+    put(crc, 32);
+    if (nbits) put(0, 8-nbits);
+
+    bz_stream bz;
+    memset(&bz, 0, sizeof(bz));
+    if (BZ2_bzDecompressInit(&bz, 0, 0) != BZ_OK) return false;
+    bz.next_in = &stream[0];
+    bz.avail_in = stream.size();
+    int ret;
+    do {
+        const size_t pos = res.size();
+        res.resize(pos + (1<<20));
+        bz.next_out = &res[pos];
+        bz.avail_out = 1<<20;
+        ret = BZ2_bzDecompress(&bz);
+        res.resize(res.size() - bz.avail_out);
+        if (ret == BZ_OK and bz.avail_in == 0 and bz.avail_out != 0) break; // truncated
+    } while (ret == BZ_OK);
+    BZ2_bzDecompressEnd(&bz);
+    return ret == BZ_STREAM_END;
+}
+
+/**
+ * Decompress the blocks of a bzip2 file with <workers> threads.
+ * Falls back to sequential decompression if the file has only one block, or if a block fails
+ * (a false magic inside compressed data); the blocks already delivered are then skipped.
+ */
+static void
+decompress_bz2(const std::string &filename, block_queue &queue, int workers)
+{
+    std::string data;
+    {
+        std::ifstream file(filename, std::ios_base::binary);
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // the blocks are the ranges from each block magic to the next magic
+    auto magics = bz2_find_magics(data, workers);
+    std::vector<std::pair<size_t, size_t>> blocks;
+    for (size_t i=0; i+1<magics.size(); i++) {
+        if (magics[i].second) blocks.push_back(std::make_pair(magics[i].first, magics[i+1].first));
+    }
+    if (blocks.size() < 2) {
+        decompress_stream(filename, queue);
+        return;
+    }
+
+    size_t next = 0;
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> threads;
+    for (int t=0; t<workers; t++) {
+        threads.push_back(std::thread([&] {
+            for (;;) {
+                const size_t idx = __sync_fetch_and_add(&next, 1);
+                if (idx >= blocks.size()) return;
+                std::string res;
+                if (!bz2_decompress_block(data, blocks[idx].first, blocks[idx].second, res)) {
+                    failed = true;
+                    queue.stop(true);
+                    return;
+                }
+                if (!queue.put(idx, std::move(res))) return;
+            }
+        }));
+    }
+    for (auto &thread : threads) thread.join();
+
+    if (failed) {
+        queue.stop(false);
+        decompress_stream(filename, queue, queue.blocks_put(), queue.bytes_put());
+    } else {
+        queue.finish();
+    }
+}
+
+/**
+ * Parse a .gz or .bz2 compressed game, decompressing on other threads while parsing.
+ * (The blocks of bzip2 files are decompressed in parallel by <workers> threads.)
+ */
+static void
+load_compressed(Game &pg, const std::string &filename, int workers)
+{
+    block_queue queue(2*workers+2);
+    std::thread producer([&] {
+        if (boost::algorithm::ends_with(filename, ".bz2")) decompress_bz2(filename, queue, workers);
+        else decompress_stream(filename, queue);
+    });
+    try {
+        pg.parse_pgsolver([&] (std::string &block) { return queue.get(block); }, workers);
+    } catch (...) {
+        queue.close();
+        producer.join();
+        throw;
+    }
+    queue.close();
+    producer.join();
+}
+
+/*------------------------------------------------------------------------*/
+
 int main(int argc, char **argv)
 {
     t_start = wctime();
@@ -182,20 +460,22 @@ int main(int argc, char **argv)
         ("v,verify", "Verify solution")
         ("p,print", "Print solution to stdout")
         ("i,input", "Input parity game", cxxopts::value<std::string>())
-        ("sol", "Input solution", cxxopts::value<std::string>())
-        ("o,output", "Output game or solution", cxxopts::value<std::string>())
+        ("sol", "Input solution (.psb for binary)", cxxopts::value<std::string>())
+        ("o,output", "Output solution (.psb for binary)", cxxopts::value<std::string>())
         ("dot", "Write .dot file (before preprocessing)", cxxopts::value<std::string>())
         /* Preprocessing */
         ("inflate", "Inflate game")
         ("compress", "Compress game")
+        ("locality", "Order the nodes of each priority for locality (breadth-first)")
         ("no-single", "Do not solve single-parity games during preprocessing")
         ("no-loops", "Do not process self-loops during preprocessing")
         ("no-wcwc", "Do not solve winner-controlled winning cycles during preprocessing")
         /* Solving */
-        ("scc", "Iteratively solve bottom SCCs")
+        ("scc", "Solve the SCCs one at a time, bottom-up")
         ("s,solver", "Use given solver (--solvers for info)", cxxopts::value<std::string>())
         ("solvers", "List available solvers")
         ("w,workers", "Number of workers for parallel code", cxxopts::value<int>())
+        ("numa", "Pin the workers and place the game in their memory (NUMA-aware mode)")
         ("z,timeout", "Number of seconds for timeout", cxxopts::value<int>())
         ;
 
@@ -227,21 +507,28 @@ int main(int argc, char **argv)
     /**
      * STEP 1
      * Read the game that must be solved.
-     * (Supports bz2 and gz compression.)
+     * (Supports bz2 and gz compression, and the binary .pgb format.)
      */
 
     Game pg;
 
+    // parallel parsing and decompression with -w workers (-w 0 and no -w for all cores, -w -1 sequential)
+    int workers = opts.count("workers") ? opts["workers"].as<int>() : 0;
+    if (workers < 0) workers = 1;
+    else if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+
     try {
         if (opts.count("input")) {
             std::string filename = opts["input"].as<std::string>();
-            io::filtering_istream in;
-            if (boost::algorithm::ends_with(filename, ".bz2")) in.push(io::bzip2_decompressor());
-            if (boost::algorithm::ends_with(filename, ".gz")) in.push(io::gzip_decompressor());
-            std::ifstream file(filename, std::ios_base::binary);
-            in.push(file);
-            pg.parse_pgsolver(in);
-            file.close();
+            if (boost::algorithm::ends_with(filename, ".pgb")) {
+                pg.load_binary(filename.c_str());
+            } else {
+                if (boost::algorithm::ends_with(filename, ".bz2") or boost::algorithm::ends_with(filename, ".gz")) {
+                    load_compressed(pg, filename, workers);
+                } else {
+                    pg.load_pgsolver(filename.c_str(), workers);
+                }
+            }
         } else {
             pg.parse_pgsolver(std::cin);
         }
@@ -258,9 +545,14 @@ int main(int argc, char **argv)
 
     try {
         if (opts.count("sol")) {
-            std::ifstream file(opts["sol"].as<std::string>());
-            pg.parse_solution(file);
-            file.close();
+            std::string filename = opts["sol"].as<std::string>();
+            if (boost::algorithm::ends_with(filename, ".psb")) {
+                pg.load_solution_binary(filename.c_str());
+            } else {
+                std::ifstream file(filename);
+                pg.parse_solution(file);
+                file.close();
+            }
             out << "solution parsed." << std::endl;
         }
     } catch (const char *err) {
@@ -275,23 +567,13 @@ int main(int argc, char **argv)
 
     if (opts.count("dot")) {
         std::ofstream file(opts["dot"].as<std::string>());
-        pg.write_dot(file);
+        pg.write_dot(file, workers);
         file.close();
         out << "dot file written." << std::endl;
     }
 
     /**
      * STEP 4
-     * Reindex the game so all nodes are in order of priority.
-     * (Remember the mapping to reverse the reindex later.)
-     */
-
-    int *mapping = new int[pg.n_nodes];
-    pg.reindex(mapping);
-    out << "parity game reindexed" << std::endl;
-
-    /**
-     * STEP 5
      * Configure the solver.
      */
 
@@ -302,6 +584,7 @@ int main(int argc, char **argv)
     if (opts.count("inflate")) en.setInflate();
     else if (opts.count("compress")) en.setCompress();
     else en.setRenumber();
+    if (opts.count("locality")) en.setLocality(true);
     if (opts.count("no-single")) en.setSolveSingle(false);
     if (opts.count("no-loops")) en.setRemoveLoops(false);
     if (opts.count("no-wcwc")) en.setRemoveWCWC(false);
@@ -319,9 +602,10 @@ int main(int argc, char **argv)
     // solving options
     if (opts.count("scc")) en.setBottomSCC(true);
     if (opts.count("workers")) en.setWorkers(opts["workers"].as<int>());
+    if (opts.count("numa")) en.setNuma(true);
 
     /**
-     * STEP 6
+     * STEP 5
      * Run the solver and report the time.
      */
 
@@ -332,7 +616,7 @@ int main(int argc, char **argv)
     out << "solving took " << std::fixed << (end-begin) << " sec." << std::endl;
 
     /**
-     * STEP 7
+     * STEP 6
      * Verify the solution.
      */
 
@@ -352,17 +636,22 @@ int main(int argc, char **argv)
     }
 
     /**
-     * STEP 8
-     * Revert reindex if we need to output.
+     * STEP 7
+     * Write or print the solution.
+     * (Oink does not reorder the game, so no reindex needs to be reverted.)
      */
 
-    if (opts.count("output") or opts.count("p")) pg.permute(mapping);
-
     if (opts.count("output")) {
         // write solution to file
         if (opts.count("output")) {
-            std::ofstream file(opts["output"].as<std::string>());
-            pg.write_sol(file);
+            std::string filename = opts["output"].as<std::string>();
+            if (boost::algorithm::ends_with(filename, ".psb")) {
+                std::ofstream file(filename, std::ios_base::binary);
+                pg.write_sol_binary(file);
+            } else {
+                std::ofstream file(filename);
+                pg.write_sol(file, workers);
+            }
         }
     }
 
@@ -388,8 +677,6 @@ int main(int argc, char **argv)
         if (banner) out << std::endl;
     }
 
-    delete[] mapping;
-
     resetsighandlers();
     return 0;
 }
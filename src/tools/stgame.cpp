@@ -113,8 +113,8 @@ main(int argc, char** argv)
         // (temporarily) remove target nodes and <from> from tgt array
         int removed = 0;
         ptrs[0] = find(tgt, tgt_count, from);
-        const int of_size = game.out[from].size();
-        for (int i=0; i<of_size; i++) ptrs[i+1] = find(tgt, tgt_count, game.out[from][i]);
+        const int of_size = game.out(from).size();
+        for (int i=0; i<of_size; i++) ptrs[i+1] = find(tgt, tgt_count, game.out(from)[i]);
         std::sort(ptrs, ptrs+of_size+1, [] (int* a, int* b) { return a > b; });
 
         for (int i=0; i<=of_size and ptrs[i] != NULL; i++) {
@@ -138,7 +138,7 @@ main(int argc, char** argv)
         game.addEdge(from, to);
 
         // update source node counts
-        const int from_count = game.out[from].size();
+        const int from_count = game.out(from).size();
         if (from_count == minD) outtodo--;
         if (from_count >= maxD) {
             // remove from src
@@ -148,7 +148,7 @@ main(int argc, char** argv)
         }
 
         // update target node counts
-        const int to_count = game.in[to].size();
+        const int to_count = game.in(to).size();
         if (to_count == minI) intodo--;
         if (to_count >= maxI) {
             // remove from tgt
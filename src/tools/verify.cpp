@@ -18,6 +18,8 @@
 #include <fstream>
 #include <sys/time.h>
 
+#include <boost/algorithm/string/predicate.hpp>
+
 #include "game.hpp"
 #include "verifier.hpp"
 
@@ -46,9 +48,13 @@ main(int argc, const char **argv)
         inp.close();
         std::cout << "game loaded." << std::endl;
 
-        std::ifstream inpsol(argv[2]);
-        pg.parse_solution(inpsol);
-        inpsol.close();
+        if (boost::algorithm::ends_with(argv[2], ".psb")) {
+            pg.load_solution_binary(argv[2]);
+        } else {
+            std::ifstream inpsol(argv[2]);
+            pg.parse_solution(inpsol);
+            inpsol.close();
+        }
         std::cout << "solution loaded." << std::endl;
 
         pg.reindex();
@@ -124,7 +124,7 @@ TSPMSolver::canlift(int node, int pl)
 
     if (owner[node] == pl) {
         // do max
-        for (int to : out[node]) {
+        for (int to : out(node)) {
             if (disabled[to]) continue;
             Prog(tmp, pms + k*to, d, pl);
             if (pm_less(pm, tmp, d, pl)) return true;
@@ -133,7 +133,7 @@ TSPMSolver::canlift(int node, int pl)
     } else {
         // do min
         int best_to = -1;
-        for (int to : out[node]) {
+        for (int to : out(node)) {
             if (disabled[to]) continue;
             Prog(tmp, pms + k*to, d, pl);
             if (best_to == -1 or pm_less(tmp, best, d, pl)) {
@@ -195,7 +195,7 @@ TSPMSolver::lift(int node, int target)
                 if (pl_max) best_ch1 = target;
                 else best_ch0 = target;
             }
-        } else for (int to : out[node]) {
+        } else for (int to : out(node)) {
             if (disabled[to]) continue;
             Prog(tmp, pms + k*to, d, pl_max);
 #ifndef NDEBUG
@@ -220,7 +220,7 @@ TSPMSolver::lift(int node, int target)
         if (trace >= 2) pm_copy(tmp, pm, 1-pl_min);
 #endif
         int best_to = -1;
-        for (int to : out[node]) {
+        for (int to : out(node)) {
             if (disabled[to]) continue;
             Prog(tmp, pms + k*to, d, pl_min);
 #ifndef NDEBUG
@@ -284,12 +284,12 @@ TSPMSolver::update(int pl)
     while (!q.empty()) {
         int n = q.front();
         q.pop();
-        for (int m : in[n]) {
+        for (int m : in(n)) {
             if (disabled[m] or unstable[m]) continue;
             if (owner[m] != pl) {
                 int best_to = -1;
                 const int d = priority[m];
-                for (int to : out[m]) {
+                for (int to : out(m)) {
                     if (disabled[to]) continue;
                     if (unstable[to]) continue;
                     Prog(tmp, pms + k*to, d, pl);
@@ -364,7 +364,7 @@ TSPMSolver::run()
 
     for (int n=n_nodes-1; n>=0; n--) {
         if (!disabled[n] and lift(n, -1)) {
-            for (int from : in[n]) if (!disabled[from] and lift(from, n)) todo_push(from);
+            for (int from : in(n)) if (!disabled[from] and lift(from, n)) todo_push(from);
         }
     }
     
@@ -376,7 +376,7 @@ TSPMSolver::run()
 
     while (!todo.empty()) {
         int n = todo_pop();
-        for (int from : in[n]) if (!disabled[from] and lift(from, n)) todo_push(from);
+        for (int from : in(n)) if (!disabled[from] and lift(from, n)) todo_push(from);
         if (last_update + 10*n_nodes < lift_count) {
             last_update = lift_count;
             update(0);
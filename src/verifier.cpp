@@ -37,14 +37,6 @@ Verifier::verify(bool fullgame, bool even, bool odd)
 {
     const int n_nodes = game->n_nodes;
 
-    // sanity check if the game is properly indexed
-    // use reindex() prior to verification
-    for (int i=1; i<n_nodes; i++) {
-        if (game->priority[i-1] > game->priority[i]) {
-            throw "game not reindexed/sorted for verification";
-        }
-    }
-
     std::vector<int> *out = new std::vector<int>[n_nodes];
 
     /**
@@ -63,7 +55,7 @@ Verifier::verify(bool fullgame, bool even, bool odd)
 
         if (game->strategy[i] == -1) {
             // no strategy, copy all edges
-            out[i].insert(out[i].end(), game->out[i].begin(), game->out[i].end());
+            out[i].insert(out[i].end(), game->out(i).begin(), game->out(i).end());
         } else {
             // only strategy
             out[i].push_back(game->strategy[i]);
@@ -79,14 +71,14 @@ Verifier::verify(bool fullgame, bool even, bool odd)
                     throw "strategy leaves dominion";
                 }
                 // check whether the strategy is actually a valid move
-                if (std::find(game->out[i].begin(), game->out[i].end(), s) == game->out[i].end()) {
+                if (std::find(game->out(i).begin(), game->out(i).end(), s) == game->out(i).end()) {
                     throw "strategy is not a valid move";
                 }
                 n_strategies++;
             }
         } else {
             // if loser, check whether the loser can escape
-            for (auto to : game->out[i]) {
+            for (auto to : game->out(i)) {
                 if (!game->solved[to] or game->winner[to] != dom) throw "loser can escape";
             }
             // and of course that no strategy is set
@@ -94,6 +86,13 @@ Verifier::verify(bool fullgame, bool even, bool odd)
         }
     }
 
+    // visit the nodes in order of priority, without reindexing the game
+    // (rank[i] is the position of node i in that order)
+    int *order = new int[n_nodes];
+    int *rank = new int[n_nodes];
+    game->sorted_order(order);
+    for (int i=0; i<n_nodes; i++) rank[order[i]] = i;
+
     // Allocate datastructures for Tarjan search
     int *done = new int[n_nodes];
     int64_t *low = new int64_t[n_nodes];
@@ -105,10 +104,11 @@ Verifier::verify(bool fullgame, bool even, bool odd)
 
     int64_t pre = 0;
 
-    for (int i=n_nodes-1; i>=0; i--) {
+    for (int r=n_nodes-1; r>=0; r--) {
         /**
          * We're going to search all SCCs reachable from node <i> with priority <p>
          */
+        const int i = order[r];
         int p = game->priority[i];
 
         /**
@@ -153,7 +153,7 @@ Verifier::verify(bool fullgame, bool even, bool odd)
             bool pushed = false;
             for (auto to : out[idx]) {
                 // skip if to higher priority or to already found scc
-                if (to > i) continue;
+                if (rank[to] > r) continue;
                 if (done[to] == p) continue;
                 if (low[to] <= bot) {
                     // not visited, add to <st> and break!
@@ -206,6 +206,8 @@ Verifier::verify(bool fullgame, bool even, bool odd)
                 printf("\n");
                 delete[] done;
                 delete[] low;
+                delete[] order;
+                delete[] rank;
 
                 throw "loser can win";
             }
@@ -225,6 +227,8 @@ Verifier::verify(bool fullgame, bool even, bool odd)
     delete[] done;
     delete[] low;
     delete[] out;
+    delete[] order;
+    delete[] rank;
 }
 
 }
@@ -22,6 +22,7 @@
 
 #include "zlk.hpp"
 #include "lace.h"
+#include "parallel.hpp"
 #include "printf.hpp"
 
 namespace pg {
@@ -31,11 +32,19 @@ static const int BOT = 0x80000001; // bottom state for vertex
 
 ZLKSolver::ZLKSolver(Oink *oink, Game *game) : Solver(oink, game), Q(game->n_nodes)
 {
+    // allocate data structures (for every run)
+    inverse = new int[n_nodes == 0 ? 1 : priority[n_nodes-1]+1];
+    region = alloc_array<int>(n_nodes);
+    winning = alloc_array<int>(n_nodes);
+    strategy = alloc_array<int>(n_nodes);
 }
 
 ZLKSolver::~ZLKSolver()
 {
     delete[] inverse;
+    free_array(region);
+    free_array(winning);
+    free_array(strategy);
 }
 
 typedef struct
@@ -46,6 +55,18 @@ typedef struct
 
 par_helper** pvec;
 
+VOID_TASK_1(initPar, ZLKSolver*, s)
+{
+    // every worker initializes (and thus first-touches) its own block of nodes
+    int from, to;
+    thread_block(s->n_nodes, LACE_WORKER_ID, lace_workers(), &from, &to);
+    for (int n=from; n<to; n++) {
+        s->region[n] = s->disabled[n] ? DIS : BOT;
+        s->winning[n] = -1;
+        s->strategy[n] = -1;
+    }
+}
+
 VOID_TASK_4(attractParT, int, pl, int, cur, int, r, ZLKSolver*, s)
 {
     int c = 0;
@@ -376,35 +397,66 @@ ZLKSolver::attractLosing(int i, int r, std::vector<int> *S, std::vector<int> *R)
 void
 ZLKSolver::run()
 {
-    iterations = 0;
+    // initialize arrays (in parallel, so every worker first-touches the memory of its nodes)
+    if (lace_workers() != 0) {
+        LACE_ME;
+        TOGETHER(initPar, this);
+    } else {
+        memset(winning, -1, sizeof(int[n_nodes]));
+        memset(strategy, -1, sizeof(int[n_nodes]));
+        for (int n=0; n<n_nodes; n++) region[n] = disabled[n] ? DIS : BOT;
+    }
+
+    solve();
+}
 
-    // allocate and initialize data structures
-    region = new int[n_nodes];
-    winning = new int[n_nodes];
-    strategy = new int[n_nodes];
+bool
+ZLKSolver::resolve()
+{
+    // only reset the nodes of the previous run (the others are still DIS) and the nodes enabled now
+    bitset reset = disabled;
+    reset.flip();
+    reset |= enabled;
+    for (auto n = reset.find_first(); n != bitset::npos; n = reset.find_next(n)) {
+        region[n] = disabled[n] ? DIS : BOT;
+        winning[n] = -1;
+        strategy[n] = -1;
+    }
+
+    solve();
+    return true;
+}
+
+void
+ZLKSolver::solve()
+{
+    iterations = 0;
 
     std::vector<int> history;
     std::vector<int> W0, W1;
     std::vector<std::vector<int>> levels;
 
-    // initialize arrays
-    memset(winning, -1, sizeof(int[n_nodes]));
-    memset(strategy, -1, sizeof(int[n_nodes]));
+    bool usePar = lace_workers() != 0;
+    WorkerP* __lace_worker = NULL;
+    Task* __lace_dq_head = NULL;
 
-    // get number of nodes and create and initialize inverse array
-    max_prio = -1;
-    for (int n=n_nodes-1; n>=0; n--) {
-        region[n] = disabled[n] ? DIS : BOT;
-        if (disabled[n]) continue;
-        const int pr = game->priority[n];
-        if (max_prio == -1) {
-            max_prio = pr;
-            inverse = new int[max_prio+1];
-            memset(inverse, -1, sizeof(int[max_prio+1]));
-        }
-        if (inverse[pr] == -1) inverse[pr] = n;
+    if (usePar) {
+        __lace_worker = lace_get_worker();
+        __lace_dq_head = lace_get_head(__lace_worker);
+    }
+
+    // the nodes of this run
+    enabled = disabled;
+    enabled.flip();
+
+    // get highest priority and initialize inverse array (the highest node of each priority)
+    if (enabled.none()) LOGIC_ERROR; // unexpected empty game
+    max_prio = priority[n_nodes-1];
+    memset(inverse, -1, sizeof(int[max_prio+1]));
+    for (auto n = enabled.find_first(); n != bitset::npos; n = enabled.find_next(n)) {
+        inverse[priority[n]] = n;
+        max_prio = priority[n];
     }
-    if (max_prio == -1) LOGIC_ERROR; // unexpected empty game
 
     // pre-allocate some space (similar to NPP)
     {
@@ -418,15 +470,9 @@ ZLKSolver::run()
     int i = inverse[max_prio];
     int next_r = 0;
 
-    bool usePar = lace_workers() != 0;
-    WorkerP* __lace_worker = NULL;
-    Task* __lace_dq_head = NULL;
-
     if (usePar) {
-        // initialize Lace and also allocate space for pvec for each worker
+        // allocate space for pvec for each worker
         const int W = lace_workers();
-        __lace_worker = lace_get_worker();
-        __lace_dq_head = lace_get_head(__lace_worker);
         pvec = (par_helper**)malloc(sizeof(par_helper*[W]));
         for (int i=0; i<W; i++) pvec[i] = (par_helper*)malloc(sizeof(par_helper) + sizeof(int[n_nodes]));
     }
@@ -668,18 +714,13 @@ ZLKSolver::run()
     }
 
     // done
-    for (int i=0; i<n_nodes; i++) {
-        if (region[i] == DIS) continue;
+    for (auto i = enabled.find_first(); i != bitset::npos; i = enabled.find_next(i)) {
 #ifndef NDEBUG
         if (winning[i] == -1) LOGIC_ERROR;
 #endif
         oink->solve(i, winning[i], strategy[i]);
     }
 
-    delete[] region;
-    delete[] winning;
-    delete[] strategy;
-
     logger << "solved with " << iterations << " iterations." << std::endl;
 }
 
@@ -32,6 +32,7 @@ public:
     virtual ~ZLKSolver();
 
     virtual void run();
+    virtual bool resolve(); // resets only the nodes of the last run and the enabled nodes
 
     int iterations;
 
@@ -42,15 +43,19 @@ protected:
     int *region;
     int *winning;
     int *strategy;
+    bitset enabled; // the nodes of the last run, which resolve resets
 
     bool to_inversion = true;
     bool only_recompute_when_attracted = true;
 
     uintqueue Q;
 
+    void solve();
+
     int attractExt(int i, int r, std::vector<int> *R);
     int attractLosing(int i, int r, std::vector<int> *S, std::vector<int> *R);
 
+    friend void initPar_WORK(WorkerP*, Task*, ZLKSolver*);
     friend void attractParT_WORK(WorkerP*, Task*, int, int, int, ZLKSolver*);
     friend int attractPar_WORK(WorkerP*, Task*, int, int, std::vector<int>*, ZLKSolver*);
     friend void updateOutcount_WORK(WorkerP*, Task*, int, int, ZLKSolver*);
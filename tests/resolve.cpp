@@ -0,0 +1,132 @@
+/*
+ * Copyright 2017-2018 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "oink.hpp"
+#include "solver.hpp"
+#include "solvers.hpp"
+#include "verifier.hpp"
+
+using namespace std;
+using namespace pg;
+
+/**
+ * Test Solver::resolve: solve the game with a fresh solver, then twice more with the same instance,
+ * after solving the winning region of even (first) or odd (second) in advance, like Oink does when
+ * a solver left part of the game unsolved. Every solution must equal the fresh one.
+ */
+class ResolveTest : public Oink
+{
+public:
+    ResolveTest(Game &game, std::ostream &out) : Oink(game, out) { }
+
+    /**
+     * Returns 0 if the solutions are equal (or the solver does not support resolve), 1 otherwise.
+     */
+    int test(int id)
+    {
+        Solvers solvers;
+        solver = id;
+        const int n = game->n_nodes;
+
+        // fresh solve
+        disabled = game->solved;
+        initOutcount();
+        std::unique_ptr<Solver> s(solvers.construct(id, this, game));
+        s->run();
+        flush();
+        if (!check()) return 1;
+
+        std::vector<int> winner(n), strategy(n);
+        for (int i=0; i<n; i++) {
+            winner[i] = game->winner[i];
+            strategy[i] = game->strategy[i];
+        }
+
+        for (int pl=0; pl<2; pl++) {
+            // solve the winning region of <pl>, unless that is the entire game
+            game->reset();
+            disabled.reset();
+            initOutcount();
+            int count = 0;
+            for (int i=0; i<n; i++) if (winner[i] == pl) count++;
+            if (count == n) continue;
+            for (int i=0; i<n; i++) if (winner[i] == pl) solve(i, pl, strategy[i]);
+            flush();
+            disabled = game->solved;
+
+            // solve the rest with the same solver
+            if (!s->resolve()) break;
+            flush();
+            if (!check()) return 1;
+            for (int i=0; i<n; i++) {
+                if ((int)game->winner[i] != winner[i]) {
+                    logger << "node " << i << " has a different winner after resolve" << std::endl;
+                    return 1;
+                }
+            }
+        }
+
+        return 0;
+    }
+
+protected:
+    bool check()
+    {
+        try {
+            Verifier v(game, logger);
+            v.verify();
+            return true;
+        } catch (const char *err) {
+            logger << "verification error: " << err << std::endl;
+            return false;
+        }
+    }
+};
+
+int
+main(int argc, const char **argv)
+{
+    if (argc != 2) {
+        cerr << "Syntax: " << argv[0] << " <filename>" << endl;
+        return -1;
+    }
+
+    int res = 0;
+    for (auto label : { "zlk", "uzlk", "npp", "spm" }) {
+        Game game;
+        try {
+            ifstream file(argv[1]);
+            game.parse_pgsolver(file);
+        } catch (const char *err) {
+            cerr << "parsing error: " << err << endl;
+            return -1;
+        }
+
+        std::stringstream log;
+        ResolveTest test(game, log);
+        if (test.test(Solvers().id(label)) != 0) {
+            cout << "resolve failed for solver " << label << endl << log.str();
+            res = 1;
+        }
+    }
+    return res;
+}
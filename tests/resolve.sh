@@ -0,0 +1,8 @@
+#!/bin/bash
+for f in vb*
+do
+    ../build/test_resolve $f > /dev/null
+    if [ $? -ne 0 ]; then
+        echo "ERROR with resolve and test file $f"
+    fi
+done